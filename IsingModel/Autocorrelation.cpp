@@ -0,0 +1,179 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Autocorrelation.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace Autocorrelation {
+
+    void init(MultiTau &correlator, int levels, int points, int averaging) {
+        correlator.points = points;
+        correlator.averaging = averaging;
+        correlator.shift.assign(levels, std::vector<double>(points, 0.0));
+        correlator.products.assign(levels, std::vector<double>(points, 0.0));
+        correlator.counts.assign(levels, std::vector<long long>(points, 0));
+        correlator.filled.assign(levels, 0);
+        correlator.pending.assign(levels, 0.0);
+        correlator.pendingCount.assign(levels, 0);
+        correlator.sum = 0.0;
+        correlator.samples = 0;
+    }
+
+    static void insert(MultiTau &correlator, int level, double x) {
+        /** Push x to the level, correlate it with the stored values and pass the block average on */
+        auto &shift = correlator.shift[level];
+        auto &products = correlator.products[level];
+        auto &counts = correlator.counts[level];
+        const int p = correlator.points;
+
+        std::rotate(shift.rbegin(), shift.rbegin() + 1, shift.rend());
+        shift[0] = x;
+        correlator.filled[level] = std::min(correlator.filled[level] + 1, p);
+        // lags below points / averaging are already covered (at a finer resolution) by the previous level
+        const int first = level ? p / correlator.averaging : 0;
+        for (int j = first; j < correlator.filled[level]; ++j) {
+            products[j] += x * shift[j];
+            ++counts[j];
+        }
+
+        if (level + 1 < static_cast<int>(correlator.shift.size())) {
+            correlator.pending[level] += x;
+            if (++correlator.pendingCount[level] == correlator.averaging) {
+                const double average = correlator.pending[level] / correlator.averaging;
+                correlator.pending[level] = 0.0;
+                correlator.pendingCount[level] = 0;
+                insert(correlator, level + 1, average);
+            }
+        }
+    }
+
+    void add(MultiTau &correlator, double x) {
+        correlator.sum += x;
+        ++correlator.samples;
+        insert(correlator, 0, x);
+    }
+
+    double mean(const MultiTau &correlator) {
+        return correlator.samples ? correlator.sum / static_cast<double>(correlator.samples) : 0.0;
+    }
+
+    double variance(const MultiTau &correlator) {
+        /** Lag-0 product of level 0 minus the squared mean, never negative */
+        if (correlator.counts.empty() || correlator.counts[0][0] == 0)
+            return 0.0;
+        const double m = mean(correlator);
+        return std::max(0.0, correlator.products[0][0] / static_cast<double>(correlator.counts[0][0]) - m * m);
+    }
+
+    double integratedTime(const MultiTau &correlator, double window, bool positive) {
+        /**
+         * tau_int = 1/2 + sum_t rho(t), integrated with the trapezoidal rule over the (non-uniform) lags
+         * and cut at the first lag t >= window * tau_int(t) (Sokal's automatic windowing).
+         * positive also cuts at the first non-positive rho, so the run controller does not take a drifting
+         * series (anticorrelated at long lags) for an uncorrelated one.
+         * Returns 0.5 (uncorrelated) while there is not enough data.
+         */
+        if (correlator.samples < 2 || correlator.counts[0][0] == 0)
+            return 0.5;
+        const double average = mean(correlator);
+        const double spread = variance(correlator);
+        if (spread <= 1e-15 * std::max(1.0, average * average))
+            return 0.5;
+
+        const int p = correlator.points;
+        double tau = 0.0;
+        double previousLag = 0.0;
+        double previousRho = 1.0;
+        double scale = 1.0;
+        for (size_t level = 0; level < correlator.shift.size(); ++level, scale *= correlator.averaging) {
+            for (int j = level ? p / correlator.averaging : 1; j < p; ++j) {
+                const long long count = correlator.counts[level][j];
+                if (count == 0)
+                    return std::max(0.5, tau);
+                const double lag = j * scale;
+                const double rho = (correlator.products[level][j] / static_cast<double>(count) - average * average) / spread;
+                if (positive && rho <= 0.0)
+                    return std::max(0.5, tau);
+                tau += 0.5 * (rho + previousRho) * (lag - previousLag);
+                previousLag = lag;
+                previousRho = rho;
+                if (lag >= window * tau)
+                    return std::max(0.5, tau);
+            }
+        }
+        return std::max(0.5, tau);
+    }
+
+    void reset(Sampler &sampler) {
+        init(sampler.absM);
+        init(sampler.energy);
+        sampler.tau = 0.5;
+        sampler.sweeps = 0;
+        sampler.pilot = 0;
+    }
+
+    void add(Sampler &sampler, double absM, double e) {
+        add(sampler.absM, absM);
+        add(sampler.energy, e);
+        ++sampler.sweeps;
+    }
+
+    int interval(Sampler &sampler) {
+        /** Sweeps between two saved configurations for the current estimate of tau_int */
+        sampler.tau = std::max(integratedTime(sampler.absM), integratedTime(sampler.energy));
+        return std::max(1, static_cast<int>(std::ceil(sampler.spacing * sampler.tau)));
+    }
+
+    static bool trusted(Sampler &sampler, bool positive) {
+        /** Checked every checkEvery sweeps: tau_int is trusted after 100 tau_int sweeps (and minimumSteps) */
+        if (sampler.sweeps < sampler.minimumSteps || sampler.sweeps % sampler.checkEvery != 0)
+            return false;
+        sampler.tau = std::max(integratedTime(sampler.absM, 5.0, positive), integratedTime(sampler.energy, 5.0, positive));
+        return static_cast<double>(sampler.sweeps) >= 100.0 * sampler.tau;
+    }
+
+    bool calibrated(Sampler &sampler) {
+        /**
+         * Called after every pilot sweep of the adaptive spacing, true when the first gap can be set:
+         * an estimate from a handful of sweeps would space the first configurations a single sweep apart
+         */
+        if (trusted(sampler, false) || sampler.sweeps >= sampler.pilotSteps) {
+            sampler.pilot = sampler.sweeps;
+            return true;
+        }
+        return false;
+    }
+
+    bool controlled(const Sampler &sampler) {
+        return sampler.targetSamples > 0.0 || sampler.targetError > 0.0;
+    }
+
+    double effectiveSamples(const Sampler &sampler) {
+        /** n / (2 tau_int) with the last estimate of tau_int */
+        return static_cast<double>(sampler.sweeps) / (2.0 * std::max(0.5, sampler.tau));
+    }
+
+    double error(const Sampler &sampler) {
+        /** Standard error of <|m|>, sqrt(2 tau(|m|) Var(|m|) / n) */
+        if (sampler.sweeps == 0)
+            return 0.0;
+        return std::sqrt(2.0 * integratedTime(sampler.absM, 5.0, true) * variance(sampler.absM) / static_cast<double>(sampler.sweeps));
+    }
+
+    bool finished(Sampler &sampler) {
+        /**
+         * Called after every production step of a controlled run, true when the targets are met.
+         * tau_int is trusted only after 100 tau_int steps, so short runs cannot stop on an early underestimate.
+         */
+        if (sampler.maximumSteps > 0 && sampler.sweeps >= sampler.maximumSteps)
+            return true;
+        if (!trusted(sampler, true))
+            return false;
+        const bool enoughSamples = sampler.targetSamples <= 0.0 || effectiveSamples(sampler) >= sampler.targetSamples;
+        const bool smallError = sampler.targetError <= 0.0 || error(sampler) <= sampler.targetError;
+        return enoughSamples && smallError;
+    }
+}
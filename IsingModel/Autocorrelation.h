@@ -0,0 +1,73 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_AUTOCORRELATION_H
+#define ISING2021_AUTOCORRELATION_H
+
+#include <vector>
+
+
+namespace Autocorrelation {
+    /**
+     * Multi-tau correlator (Ramirez et al., J. Chem. Phys. 133, 154103 (2010)).
+     * Level 0 keeps the last `points` samples, every next level keeps averages of `averaging` samples
+     * of the previous one, so lags up to points * averaging^(levels-1) cost O(levels * points) memory
+     * and O(points) work per sample on average.
+     */
+    struct MultiTau {
+        int points{16};
+        int averaging{2};
+        std::vector<std::vector<double>> shift;      // shift[k][j]: j-th newest value of level k
+        std::vector<std::vector<double>> products;   // products[k][j]: sum of x(t) * x(t - lag)
+        std::vector<std::vector<long long>> counts;
+        std::vector<int> filled;                     // valid entries of shift[k]
+        std::vector<double> pending;                 // sum of the values waiting for the next level
+        std::vector<int> pendingCount;
+        double sum{0.0};
+        long long samples{0};
+    };
+
+    struct Sampler {
+        /**
+         * Adaptive spacing of the saved configurations: the next configuration is written after
+         * spacing * tau_int sweeps, tau_int = max(tau(|m|), tau(e)) estimated online.
+         * spacing == 0 keeps the fixed takeEvery.
+         */
+        double spacing{0.0};
+        int pilotSteps{10000};        // at most this many sweeps measure tau_int before the first configuration
+        /**
+         * Run controller of the production phase: instead of MCS steps run until the effective sample size
+         * n / (2 tau_int) reaches targetSamples and/or the error bar of <|m|> drops below targetError,
+         * between minimumSteps and maximumSteps. Both targets 0 keep the fixed MCS.
+         */
+        double targetSamples{0.0};
+        double targetError{0.0};
+        int minimumSteps{100};
+        int maximumSteps{0};
+        int checkEvery{16};
+        MultiTau absM;
+        MultiTau energy;
+        double tau{0.0};              // last estimate (sweeps)
+        long long sweeps{0};          // sweeps of the last run fed to the estimator
+        long long pilot{0};           // of them before the first configuration (adaptive spacing)
+    };
+
+    void init(MultiTau &correlator, int levels = 20, int points = 16, int averaging = 2);
+    void add(MultiTau &correlator, double x);
+    double integratedTime(const MultiTau &correlator, double window = 5.0, bool positive = false);
+    double mean(const MultiTau &correlator);
+    double variance(const MultiTau &correlator);
+
+    void reset(Sampler &sampler);
+    void add(Sampler &sampler, double absM, double e);
+    int interval(Sampler &sampler);
+    bool calibrated(Sampler &sampler);
+    bool controlled(const Sampler &sampler);
+    double effectiveSamples(const Sampler &sampler);
+    double error(const Sampler &sampler);
+    bool finished(Sampler &sampler);
+}
+
+
+#endif //ISING2021_AUTOCORRELATION_H
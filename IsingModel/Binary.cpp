@@ -0,0 +1,100 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Binary.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+
+namespace Binary {
+
+    const uint32_t fixedHeaderSize = 64;
+    const std::streamoff recordsOffset = 48;
+
+    template<typename Value>
+    static void writeValue(std::ostream &file, Value value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    uint32_t recordSize(int size) {
+        return static_cast<uint32_t>(sizeof(uint32_t) + (size + 7) / 8);
+    }
+
+    uint64_t beginRun(const std::string &fileName, const Header &header) {
+        std::error_code error;
+        const auto existing = std::filesystem::file_size(fileName, error);
+        const uint64_t offset = error ? 0 : existing;
+        std::ofstream file{fileName, std::ios::binary | std::ios::app};
+        if (!file) {
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+            return offset;
+        }
+        const auto count = static_cast<uint32_t>(header.temperatures.size());
+        file.write("ISINGCF1", 8);
+        writeValue<uint32_t>(file, fixedHeaderSize + 12 * count);
+        writeValue<uint32_t>(file, version);
+        writeValue<int32_t>(file, header.L);
+        writeValue<int32_t>(file, header.standardIsing ? 1 : 0);
+        writeValue<int32_t>(file, header.MCS);
+        writeValue<int32_t>(file, header.warmingTime);
+        writeValue<int32_t>(file, header.takeEvery);
+        writeValue<uint32_t>(file, count);
+        writeValue<uint64_t>(file, header.seed);
+        writeValue<uint64_t>(file, 0);
+        writeValue<uint32_t>(file, recordSize(header.L * header.L));
+        writeValue<uint32_t>(file, 0);
+        for (const double T : header.temperatures)
+            writeValue<double>(file, T);
+        for (uint32_t k = 0; k < count; ++k)
+            writeValue<int32_t>(file, k < header.steps.size() ? header.steps[k] : header.MCS);
+        return offset;
+    }
+
+    void finishRun(const std::string &fileName, uint64_t headerOffset) {
+        /** The run owns the rest of the file, every byte after its header belongs to one of its records */
+        std::fstream file{fileName, std::ios::binary | std::ios::in | std::ios::out};
+        if (!file) {
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+            return;
+        }
+        uint32_t headerSize = 0, size = 0;
+        file.seekg(static_cast<std::streamoff>(headerOffset) + 8);
+        file.read(reinterpret_cast<char *>(&headerSize), sizeof(headerSize));
+        file.seekg(static_cast<std::streamoff>(headerOffset) + 56);
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+        const uint64_t end = std::filesystem::file_size(fileName);
+        const uint64_t records = size ? (end - headerOffset - headerSize) / size : 0;
+        file.seekp(static_cast<std::streamoff>(headerOffset) + recordsOffset);
+        writeValue<uint64_t>(file, records);
+    }
+
+    template<typename Spins>
+    static void writeBits(std::ostream &file, uint32_t temperatureIndex, const Spins &spins) {
+        std::vector<char> bytes((spins.size() + 7) / 8, 0);
+        for (size_t i = 0; i < spins.size(); ++i)
+            if (spins[i] > 0)
+                bytes[i / 8] = static_cast<char>(bytes[i / 8] | (1 << (i % 8)));
+        writeValue<uint32_t>(file, temperatureIndex);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void writeRecord(std::ostream &file, uint32_t temperatureIndex, const std::vector<int> &spins) {
+        writeBits(file, temperatureIndex, spins);
+    }
+
+    void writeRecord(std::ostream &file, uint32_t temperatureIndex, const std::vector<bool> &spins) {
+        writeBits(file, temperatureIndex, spins);
+    }
+
+    void appendRecord(std::string &buffer, uint32_t temperatureIndex, const std::vector<int8_t> &spins) {
+        const size_t start = buffer.size();
+        buffer.append(reinterpret_cast<const char *>(&temperatureIndex), sizeof(temperatureIndex));
+        buffer.append((spins.size() + 7) / 8, '\0');
+        char *bytes = buffer.data() + start + sizeof(temperatureIndex);
+        for (size_t i = 0; i < spins.size(); ++i)
+            if (spins[i] > 0)
+                bytes[i / 8] = static_cast<char>(bytes[i / 8] | (1 << (i % 8)));
+    }
+}
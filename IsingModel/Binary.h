@@ -0,0 +1,61 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_BINARY_H
+#define ISING2021_BINARY_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace Binary {
+    /**
+     * Bit-packed configuration files (format=bin), read by utils/helpers.read_binary_configurations.
+     * Every run appends a self-describing header followed by fixed-size records, so record i of a run starts at
+     * headerOffset + headerSize + i * recordSize. All values are native-endian (little-endian on x86):
+     *
+     *   0  char[8]  "ISINGCF1"         36 uint32  temperatures
+     *   8  uint32   headerSize         40 uint64  seed
+     *  12  uint32   version (1)        48 uint64  records (written when the run is finished)
+     *  16  int32    L                  56 uint32  recordSize
+     *  20  int32    encoding           60 uint32  reserved
+     *  24  int32    MCS                64 float64 T[temperatures]
+     *  28  int32    warmingTime           int32   steps[temperatures]
+     *  32  int32    takeEvery
+     *
+     * steps are the planned production steps of every temperature (MCS except for grid=adaptive, version 2).
+     * records stays 0 when the run did not finish, the readers then take every record up to the next header.
+     * encoding 1: spins -1/1, 0: spins 0/1. A record is the uint32 index of its temperature in T followed by
+     * (L*L + 7) / 8 bytes, bit i % 8 of byte i / 8 (least significant first) set for the spin i up (1).
+     */
+    struct Header {
+        int L{};
+        bool standardIsing{true};
+        int MCS{};
+        int warmingTime{};
+        int takeEvery{};
+        uint64_t seed{};
+        std::vector<double> temperatures;
+        std::vector<int> steps;                       // production steps of every temperature
+    };
+
+    const uint32_t version = 2;
+
+    uint32_t recordSize(int size);
+
+    // Appends the header of a new run (0 records) to fileName and returns its offset
+    uint64_t beginRun(const std::string &fileName, const Header &header);
+    // Fills in the records of the run from the size of the file
+    void finishRun(const std::string &fileName, uint64_t headerOffset);
+
+    void writeRecord(std::ostream &file, uint32_t temperatureIndex, const std::vector<int> &spins);
+    void writeRecord(std::ostream &file, uint32_t temperatureIndex, const std::vector<bool> &spins);
+    // The bytes of writeRecord appended to buffer (spins -1/1 or 0/1)
+    void appendRecord(std::string &buffer, uint32_t temperatureIndex, const std::vector<int8_t> &spins);
+}
+
+
+#endif //ISING2021_BINARY_H
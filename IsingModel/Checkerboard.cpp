@@ -0,0 +1,254 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Checkerboard.h"
+#include "RandomBuffer.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+
+namespace Checkerboard {
+/** ************************************************************************
+ *
+ * Checkerboard (red/black) updating of the standard {-1,1} model
+ * Sites of one colour do not interact, so the whole colour is updated at once
+ *
+ * *************************************************************************
+ * */
+
+    bool supports(int L) {
+        return L >= 2 && L % 2 == 0;
+    }
+
+    int teamSize(int L, int threads) {
+        // a thread gets at least 16 rows, smaller lattices are not worth the fork-join of every colour update
+        return std::max(1, std::min(threads, L / 16));
+    }
+
+    void init(Lattice &lattice, int L, std::shared_ptr<ThreadTeam> team) {
+        lattice.L = L;
+        lattice.half = L / 2;
+        lattice.sites = L * lattice.half;
+        for (auto &c : lattice.colour)
+            c.assign(lattice.sites, 1);
+        lattice.neighborSum.assign(lattice.sites, 0);
+        lattice.random.assign(lattice.sites, 0);
+        lattice.team = team && team->size() > 1 ? std::move(team) : nullptr;
+    }
+
+    void load(Lattice &lattice, const std::vector<int> &spins) {
+        /** Scatter the spins from the row-major layout to the two colour arrays */
+        const int L = lattice.L;
+        for (int row = 0; row < L; ++row)
+            for (int col = 0; col < L; ++col)
+                lattice.colour[(row + col) & 1][row * lattice.half + col / 2] = static_cast<int8_t>(spins[row * L + col]);
+    }
+
+    void store(const Lattice &lattice, std::vector<int> &spins) {
+        /** Gather the colour arrays back to the row-major layout used by writeConfigurations */
+        const int L = lattice.L;
+        for (int row = 0; row < L; ++row)
+            for (int col = 0; col < L; ++col)
+                spins[row * L + col] = lattice.colour[(row + col) & 1][row * lattice.half + col / 2];
+    }
+
+    std::array<uint32_t, 5> calculateThresholds(const std::array<double, 5> &boltzmannCoeffs) {
+        /** Same integer thresholds as the buffered single-spin updates: flip when a raw word r < t */
+        return RandomBuffer::calculateThresholds(boltzmannCoeffs);
+    }
+
+    void setKey(Lattice &lattice, pcg64 &rng) {
+        /** The Philox key of a run comes from the (reproducible) stream of its temperature */
+        lattice.key = Philox::makeKey(rng());
+        lattice.updates = 0;
+    }
+
+    static void calculateNeighborSums(Lattice &lattice, int c, int rowBegin, int rowEnd) {
+        /**
+         * For the site k in the row r of colour c (column 2k + p, p = (r + c) % 2) the neighbours are:
+         * -> up/down: other[r -/+ 1][k]
+         * -> left/right: other[r][k] and other[r][k - 1] (p == 0) or other[r][k + 1] (p == 1)
+         * Only the rows [rowBegin, rowEnd) of colour c are written, the other colour is only read.
+         */
+        const int L = lattice.L;
+        const int half = lattice.half;
+        const int8_t *other = lattice.colour[1 - c].data();
+        int8_t *sum = lattice.neighborSum.data();
+
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            const int8_t *src = other + row * half;
+            const int8_t *above = other + ((row + L - 1) % L) * half;
+            const int8_t *below = other + ((row + 1) % L) * half;
+            int8_t *dst = sum + row * half;
+            if (((row + c) & 1) == 0) {
+                dst[0] = src[half - 1];
+                std::memcpy(dst + 1, src, half - 1);
+            } else {
+                std::memcpy(dst, src + 1, half - 1);
+                dst[half - 1] = src[0];
+            }
+            for (int j = 0; j < half; ++j)
+                dst[j] += src[j] + above[j] + below[j];
+        }
+    }
+
+    static void flipAccepted(int8_t *spins,
+                             const int8_t *neighborSum,
+                             const uint32_t *random,
+                             const std::array<uint32_t, 5> &thresholds,
+                             int begin,
+                             int end) {
+        /**
+         * Scalar Metropolis kernel: ss = s * sum(neighbours), dE = 2 * ss
+         * flip if dE <= 0 or random < threshold[(ss + 4) / 2]
+         */
+        for (int j = begin; j < end; ++j) {
+            const int ss = spins[j] * neighborSum[j];
+            const bool flip = (ss <= 0) | (random[j] < thresholds[(ss + 4) >> 1]);
+            spins[j] = static_cast<int8_t>(flip ? -spins[j] : spins[j]);
+        }
+    }
+
+#if defined(__AVX512BW__)
+    static int flipAcceptedSIMD(int8_t *spins,
+                                const int8_t *neighborSum,
+                                const uint32_t *random,
+                                const std::array<uint32_t, 5> &thresholds,
+                                int sites) {
+        /** AVX-512: 64 sites per iteration, returns the number of processed sites */
+        alignas(64) uint32_t table[16]{};
+        std::memcpy(table, thresholds.data(), sizeof(uint32_t) * thresholds.size());
+        const __m512i lookup = _mm512_load_si512(table);
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i four = _mm512_set1_epi32(4);
+
+        int j = 0;
+        for (; j + 64 <= sites; j += 64) {
+            __m512i s = _mm512_loadu_si512(spins + j);
+            const __m512i sum = _mm512_loadu_si512(neighborSum + j);
+            const __m512i ss = _mm512_mask_sub_epi8(sum, _mm512_movepi8_mask(s), zero, sum);
+            const __mmask64 positive = _mm512_cmpgt_epi8_mask(ss, zero);
+
+            const __m512i ss0 = _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(ss, 0));
+            const __m512i ss1 = _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(ss, 1));
+            const __m512i ss2 = _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(ss, 2));
+            const __m512i ss3 = _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(ss, 3));
+            const __m512i cls[4] = {_mm512_srai_epi32(_mm512_add_epi32(ss0, four), 1),
+                                    _mm512_srai_epi32(_mm512_add_epi32(ss1, four), 1),
+                                    _mm512_srai_epi32(_mm512_add_epi32(ss2, four), 1),
+                                    _mm512_srai_epi32(_mm512_add_epi32(ss3, four), 1)};
+            __mmask64 accepted = 0;
+            for (int q = 0; q < 4; ++q) {
+                const __m512i threshold = _mm512_permutexvar_epi32(cls[q], lookup);
+                const __m512i r = _mm512_loadu_si512(random + j + 16 * q);
+                accepted |= static_cast<__mmask64>(_mm512_cmplt_epu32_mask(r, threshold)) << (16 * q);
+            }
+            const __mmask64 flip = ~positive | accepted;
+            s = _mm512_mask_sub_epi8(s, flip, zero, s);
+            _mm512_storeu_si512(spins + j, s);
+        }
+        return j;
+    }
+#elif defined(__AVX2__)
+    static int flipAcceptedSIMD(int8_t *spins,
+                                const int8_t *neighborSum,
+                                const uint32_t *random,
+                                const std::array<uint32_t, 5> &thresholds,
+                                int sites) {
+        /** AVX2: 32 sites per iteration, returns the number of processed sites */
+        alignas(32) uint32_t table[8]{};
+        std::memcpy(table, thresholds.data(), sizeof(uint32_t) * thresholds.size());
+        const __m256i lookup = _mm256_load_si256(reinterpret_cast<const __m256i *>(table));
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i four = _mm256_set1_epi32(4);
+        const __m256i bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+        // expands a 32-bit mask to one byte per bit
+        const __m256i byteOfMask = _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101,
+                                                      0x0202020202020202, 0x0303030303030303);
+        const __m256i bitOfByte = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+
+        int j = 0;
+        for (; j + 32 <= sites; j += 32) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(spins + j));
+            const __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(neighborSum + j));
+            const __m256i ss = _mm256_sign_epi8(sum, s);
+            const auto positive = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(ss, zero)));
+
+            const __m128i lo = _mm256_castsi256_si128(ss);
+            const __m128i hi = _mm256_extracti128_si256(ss, 1);
+            const __m128i chunks[4] = {lo, _mm_srli_si128(lo, 8), hi, _mm_srli_si128(hi, 8)};
+            uint32_t accepted = 0;
+            for (int q = 0; q < 4; ++q) {
+                const __m256i cls = _mm256_srai_epi32(_mm256_add_epi32(_mm256_cvtepi8_epi32(chunks[q]), four), 1);
+                const __m256i threshold = _mm256_permutevar8x32_epi32(lookup, cls);
+                const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(random + j + 8 * q));
+                // unsigned r < threshold
+                const __m256i lt = _mm256_cmpgt_epi32(_mm256_xor_si256(threshold, bias), _mm256_xor_si256(r, bias));
+                accepted |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(lt))) << (8 * q);
+            }
+            const uint32_t flip = ~positive | accepted;
+            __m256i mask = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(flip)), byteOfMask);
+            mask = _mm256_cmpeq_epi8(_mm256_and_si256(mask, bitOfByte), bitOfByte);
+            s = _mm256_sub_epi8(_mm256_xor_si256(s, mask), mask);   // -s where mask is set
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(spins + j), s);
+        }
+        return j;
+    }
+#else
+    static int flipAcceptedSIMD(int8_t *, const int8_t *, const uint32_t *, const std::array<uint32_t, 5> &, int) {
+        return 0;
+    }
+#endif
+
+    static void updateRows(Lattice &lattice, int c, int rowBegin, int rowEnd) {
+        /** Metropolis update of the sites with the colour c in the rows [rowBegin, rowEnd) */
+        calculateNeighborSums(lattice, c, rowBegin, rowEnd);
+        const int begin = rowBegin * lattice.half;
+        const int end = rowEnd * lattice.half;
+        Philox::fill(lattice.random.data(), begin, end, lattice.key, lattice.updates);
+
+        int8_t *spins = lattice.colour[c].data();
+        const int done = begin + flipAcceptedSIMD(spins + begin, lattice.neighborSum.data() + begin,
+                                                  lattice.random.data() + begin, lattice.thresholds, end - begin);
+        flipAccepted(spins, lattice.neighborSum.data(), lattice.random.data(), lattice.thresholds, done, end);
+    }
+
+    void updateColour(Lattice &lattice, int c) {
+        /** Metropolis update of every site with the colour c, the rows are split among the team */
+        if (!lattice.team) {
+            updateRows(lattice, c, 0, lattice.L);
+        } else {
+            const int threads = lattice.team->size();
+            lattice.team->run([&](int t) {
+                updateRows(lattice, c, lattice.L * t / threads, lattice.L * (t + 1) / threads);
+            });
+        }
+        ++lattice.updates;
+    }
+
+    void monteCarloStep(Lattice &lattice) {
+        /** One MCS = one update of each colour (every site is visited once) */
+        updateColour(lattice, 0);
+        updateColour(lattice, 1);
+    }
+
+    void thermalize(Lattice &lattice, int warmingTime) {
+        /** warmingTime is given in single-spin updates, as in MetropolisRSU::thermalize */
+        const int size = 2 * lattice.sites;
+        const int sweeps = (warmingTime + size - 1) / size;
+        for (int k = 0; k < sweeps; ++k)
+            monteCarloStep(lattice);
+    }
+
+    double magnetization(const Lattice &lattice) {
+        int m = 0;
+        for (const auto &c : lattice.colour)
+            for (const auto &spin : c)
+                m += spin;
+        return static_cast<double>(m) / (2 * lattice.sites);
+    }
+}
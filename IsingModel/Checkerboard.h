@@ -0,0 +1,55 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_CHECKERBOARD_H
+#define ISING2021_CHECKERBOARD_H
+
+#include "Utils.h"
+#include "Philox.h"
+#include "ThreadTeam.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace Checkerboard {
+    /**
+     * Red/black storage of the standard {-1,1} lattice.
+     * Site (row, col) has the colour c = (row + col) % 2 and is kept in colour[c][row * half + col / 2],
+     * so every neighbour of a site belongs to the other colour and one colour can be updated at once.
+     * Works only for even L (otherwise periodic boundaries mix the colours).
+     * The random word of a site is Philox(key, colour update, site), so the rows can be split among
+     * any number of threads and the trajectory stays bitwise the same.
+     */
+    struct Lattice {
+        int L{};
+        int half{};                                   // sites of one colour in a single row (L/2)
+        int sites{};                                  // sites of one colour (L*L/2)
+        std::array<std::vector<int8_t>, 2> colour;
+        std::vector<int8_t> neighborSum;              // sum of the four neighbours for the colour being updated
+        std::vector<uint32_t> random;                 // raw random words, one per site of the colour
+        std::array<uint32_t, 5> thresholds{};         // integer acceptance thresholds, indexed like boltzmannCoeffs
+        Philox::Key key{};                            // drawn from the stream of the temperature in setKey
+        uint64_t updates{0};                          // colour updates since setKey (Philox counter)
+        std::shared_ptr<ThreadTeam> team;             // null -> single-threaded, shared by the lattices of a worker
+    };
+
+    bool supports(int L);
+    int teamSize(int L, int threads);
+    void init(Lattice &lattice, int L, std::shared_ptr<ThreadTeam> team = nullptr);
+    void load(Lattice &lattice, const std::vector<int> &spins);
+    void store(const Lattice &lattice, std::vector<int> &spins);
+
+    std::array<uint32_t, 5> calculateThresholds(const std::array<double, 5> &boltzmannCoeffs);
+    void setKey(Lattice &lattice, pcg64 &rng);
+
+    void updateColour(Lattice &lattice, int c);
+    void monteCarloStep(Lattice &lattice);
+    void thermalize(Lattice &lattice, int warmingTime);
+    double magnetization(const Lattice &lattice);
+}
+
+
+#endif //ISING2021_CHECKERBOARD_H
@@ -0,0 +1,56 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Equilibration.h"
+#include <cmath>
+
+
+namespace Equilibration {
+
+    void reset(Detector &detector) {
+        detector.absM.assign(1, 0.0);
+        detector.energy.assign(1, 0.0);
+        detector.passed = 0;
+        detector.steps = 0;
+        detector.converged = false;
+    }
+
+    static void quarter(const std::vector<double> &prefix, int begin, int length, int blocks,
+                        double &mean, double &squaredError) {
+        /** Mean of the samples [begin, begin + length) and its squared standard error from the block means */
+        const int blockLength = length / blocks;
+        mean = (prefix[begin + blockLength * blocks] - prefix[begin]) / (blockLength * blocks);
+        double sumSquares = 0.0;
+        for (int b = 0; b < blocks; ++b) {
+            const double blockMean = (prefix[begin + (b + 1) * blockLength] - prefix[begin + b * blockLength]) / blockLength;
+            sumSquares += (blockMean - mean) * (blockMean - mean);
+        }
+        squaredError = sumSquares / (blocks * (blocks - 1.0));
+    }
+
+    static bool drifts(const std::vector<double> &prefix, int steps, int blocks, double tolerance) {
+        const int length = steps / 4;
+        double first, firstError, second, secondError;
+        quarter(prefix, steps - 2 * length, length, blocks, first, firstError);
+        quarter(prefix, steps - length, length, blocks, second, secondError);
+        return std::abs(second - first) > tolerance * std::sqrt(firstError + secondError);
+    }
+
+    bool add(Detector &detector, double absM, double e) {
+        detector.absM.push_back(detector.absM.back() + absM);
+        detector.energy.push_back(detector.energy.back() + e);
+        const int steps = static_cast<int>(++detector.steps);
+
+        if (steps >= detector.maximumSteps)
+            return true;
+        if (steps < detector.minimumSteps || steps % detector.checkEvery != 0)
+            return false;
+
+        const bool stationary = !drifts(detector.absM, steps, detector.blocks, detector.tolerance)
+                                && !drifts(detector.energy, steps, detector.blocks, detector.tolerance);
+        detector.passed = stationary ? detector.passed + 1 : 0;
+        detector.converged = detector.passed >= detector.confirmations;
+        return detector.converged;
+    }
+}
@@ -0,0 +1,39 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_EQUILIBRATION_H
+#define ISING2021_EQUILIBRATION_H
+
+#include <vector>
+
+
+namespace Equilibration {
+    /**
+     * Sliding-window drift test that ends the thermalization once |m| and e are stationary:
+     * the last half of the series seen so far is split into two quarters and their means must agree
+     * within `tolerance` standard errors (block averages, so the correlations are accounted for)
+     * at `confirmations` consecutive checks. Both series are kept as prefix sums, a check is O(blocks).
+     */
+    struct Detector {
+        bool automatic{false};            // false: the fixed warmingTime is used
+        int minimumSteps{64};
+        int maximumSteps{100000};
+        int checkEvery{16};
+        int blocks{8};                    // blocks per quarter
+        double tolerance{2.0};
+        int confirmations{3};
+        std::vector<double> absM;         // prefix sums, absM[t] = sum of the first t samples
+        std::vector<double> energy;
+        int passed{0};
+        long long steps{0};               // monte carlo steps of the last thermalization
+        bool converged{false};            // false if it stopped at maximumSteps
+    };
+
+    void reset(Detector &detector);
+    // true once the series are stationary or maximumSteps is reached
+    bool add(Detector &detector, double absM, double e);
+}
+
+
+#endif //ISING2021_EQUILIBRATION_H
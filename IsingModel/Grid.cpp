@@ -0,0 +1,111 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Grid.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+namespace Grid {
+
+    // Threshold of the labels in utils/helpers.py (ordered below, disordered above)
+    const double labelTemperature = 2.26;
+
+    std::vector<double> uniform(double Tmax, double Tmin, double dT) {
+        std::vector<double> temperatures;
+        for (int k = 0; Tmax - k * dT > Tmin + 1e-9 * dT; ++k)
+            temperatures.push_back(Tmax - k * dT);
+        return temperatures;
+    }
+
+    Window criticalWindow(const std::vector<double> &temperatures, const std::vector<Observables::Summary> &pilot) {
+        /**
+         * The window spans the chi maximum and the steepest segment of U(T), extended by one coarse step on both
+         * sides, since the finite-size peak of chi and the Binder crossing region do not coincide exactly
+         */
+        const size_t count = temperatures.size();
+        if (count < 2)
+            return {count ? temperatures.front() : 0.0, 0.0};
+        size_t peak = 0, steepest = 0;
+        double slope = -1.0;
+        for (size_t k = 0; k < count; ++k) {
+            if (pilot[k].susceptibility > pilot[peak].susceptibility)
+                peak = k;
+            if (k + 1 < count) {
+                const double current = std::abs(pilot[k].binder - pilot[k + 1].binder) /
+                                       std::abs(temperatures[k] - temperatures[k + 1]);
+                if (current > slope) {
+                    slope = current;
+                    steepest = k;
+                }
+            }
+        }
+        const double step = std::abs(temperatures[0] - temperatures[1]);
+        const double low = std::min({temperatures[peak], temperatures[steepest], temperatures[steepest + 1]}) - step;
+        const double high = std::max({temperatures[peak], temperatures[steepest], temperatures[steepest + 1]}) + step;
+        return {(low + high) / 2.0, (high - low) / 2.0};
+    }
+
+    std::vector<double> refine(const std::vector<double> &coarse, const Window &window, double dT) {
+        std::vector<double> temperatures = coarse;
+        const double low = window.center - window.halfWidth;
+        const int count = static_cast<int>(std::floor(2.0 * window.halfWidth / dT + 1e-9));
+        for (int k = 0; k <= count; ++k) {
+            const double T = low + k * dT;
+            const bool present = std::any_of(coarse.begin(), coarse.end(),
+                                             [&](double t) { return std::abs(t - T) < dT / 2.0; });
+            const bool inside = T > coarse.back() - dT / 2.0 && T < coarse.front() + dT / 2.0;
+            if (!present && inside)
+                temperatures.push_back(T);
+        }
+        std::sort(temperatures.begin(), temperatures.end(), std::greater<>());
+        return temperatures;
+    }
+
+    std::vector<int> allocate(const std::vector<double> &temperatures, const Window &window,
+                              int MCS, int takeEvery, double focus) {
+        std::vector<int> steps;
+        for (const double T : temperatures) {
+            const double distance = window.halfWidth > 0.0 ? (T - window.center) / window.halfWidth : 0.0;
+            const double factor = 1.0 + (focus - 1.0) * std::exp(-distance * distance);
+            const long long target = std::llround(MCS * factor / takeEvery) * takeEvery;
+            steps.push_back(static_cast<int>(std::max<long long>(takeEvery, target)));
+        }
+        return steps;
+    }
+
+    std::string manifestFileName(const std::string &dataFileName) {
+        /** Data_C_L20_MCS200000_WT20000.txt -> Data_C_L20_MCS200000_WT20000_grid.txt */
+        auto dot = dataFileName.find_last_of('.');
+        return dataFileName.substr(0, dot) + "_grid.txt";
+    }
+
+    void writeManifest(const std::string &dataFileName,
+                       const std::vector<double> &temperatures,
+                       const std::vector<int> &steps,
+                       int takeEvery,
+                       int saveData,
+                       const Window &window) {
+        /**
+         * Appended like the metadata, one block per run. The rows of the data file follow the temperatures
+         * in this order (rows each), so the labels can be expanded from the manifest instead of a uniform grid.
+         */
+        std::ofstream file{manifestFileName(dataFileName), std::ios::app};
+        if (!file) {
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+            return;
+        }
+        file << "# window " << window.center - window.halfWidth << " " << window.center + window.halfWidth << "\n";
+        file << "# index T MCS rows label\n";
+        file << std::setprecision(10);
+        for (size_t k = 0; k < temperatures.size(); ++k) {
+            const int rows = saveData ? 1 : steps[k] / takeEvery + 1;
+            file << k << " " << temperatures[k] << " " << steps[k] << " " << rows << " "
+                 << (temperatures[k] > labelTemperature ? 1 : 0) << "\n";
+        }
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_GRID_H
+#define ISING2021_GRID_H
+
+#include "Observables.h"
+#include <string>
+#include <vector>
+
+
+namespace Grid {
+    /**
+     * Temperature grids of a run. The uniform grid goes from Tmax down by dT while T > Tmin, with T = Tmax - k dT
+     * computed from the index instead of accumulated. The adaptive planner takes a coarse grid with pilot
+     * results on it, finds the critical window around the peak of chi and the steepest Binder slope,
+     * inserts dT-spaced temperatures there and gives the temperatures in the window more production steps.
+     */
+    struct Window {
+        double center{};
+        double halfWidth{};
+    };
+
+    std::vector<double> uniform(double Tmax, double Tmin, double dT);
+
+    Window criticalWindow(const std::vector<double> &temperatures, const std::vector<Observables::Summary> &pilot);
+
+    // Coarse temperatures plus the dT grid inside the window, descending
+    std::vector<double> refine(const std::vector<double> &coarse, const Window &window, double dT);
+
+    // MCS * (1 + (focus - 1) exp(-((T - center) / halfWidth)^2)), rounded to a multiple of takeEvery
+    std::vector<int> allocate(const std::vector<double> &temperatures, const Window &window,
+                              int MCS, int takeEvery, double focus);
+
+    std::string manifestFileName(const std::string &dataFileName);
+
+    // One line per temperature: index, T, production steps, rows appended to the data file, label T > Tc
+    void writeManifest(const std::string &dataFileName,
+                       const std::vector<double> &temperatures,
+                       const std::vector<int> &steps,
+                       int takeEvery,
+                       int saveData,
+                       const Window &window);
+}
+
+
+#endif //ISING2021_GRID_H
@@ -0,0 +1,107 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Helical.h"
+
+
+namespace Helical {
+/** ************************************************************************
+ *
+ * Single-spin updates with helical boundary conditions on a ghost-padded array
+ *
+ * *************************************************************************
+ * */
+
+    void init(Lattice &lattice, int L) {
+        lattice.L = L;
+        lattice.size = L * L;
+        lattice.padded.assign(lattice.size + 2 * L, 0);
+    }
+
+    static void refreshGhosts(Lattice &lattice) {
+        const int L = lattice.L;
+        const int N = lattice.size;
+        for (int g = 0; g < L; ++g) {
+            lattice.padded[g] = lattice.padded[N + g];
+            lattice.padded[N + L + g] = lattice.padded[L + g];
+        }
+    }
+
+    void load(Lattice &lattice, const std::vector<int> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            lattice.padded[lattice.L + i] = static_cast<int8_t>(spins[i]);
+        refreshGhosts(lattice);
+    }
+
+    void load(Lattice &lattice, const std::vector<bool> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            lattice.padded[lattice.L + i] = spins[i];
+        refreshGhosts(lattice);
+    }
+
+    void store(const Lattice &lattice, std::vector<int> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = lattice.padded[lattice.L + i];
+    }
+
+    void store(const Lattice &lattice, std::vector<bool> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = lattice.padded[lattice.L + i];
+    }
+
+    static inline void setSpin(int8_t *padded, int L, int N, int i, int8_t value) {
+        /** Write the spin i and its ghost copy (the first and the last L sites have one) */
+        padded[L + i] = value;
+        if (i < L)
+            padded[N + L + i] = value;
+        if (i >= N - L)
+            padded[i - (N - L)] = value;
+    }
+
+    static inline void updateSpin(int8_t *padded, int L, int N, int i, bool standardIsing,
+                                  RandomBuffer::Buffer &random, const std::array<uint32_t, 5> &thresholds,
+                                  long long &magnetization, long long &energy) {
+        const int8_t *p = padded + L + i;
+        const int sum = p[-1] + p[1] + p[-L] + p[L];
+        if (standardIsing) {
+            const int dE = 2 * p[0] * sum;
+            if (dE <= 0 || RandomBuffer::next(random) < thresholds[(dE + 8) >> 2]) {
+                magnetization -= 2 * p[0];
+                energy += dE;
+                setSpin(padded, L, N, i, static_cast<int8_t>(-p[0]));
+            }
+        } else {
+            // change = dE / 2 in the {-1,1} mapping
+            const int change = p[0] ? 2 * sum - 4 : 4 - 2 * sum;
+            const int index = (change + 4) / 2;
+            if (index <= 2 || RandomBuffer::next(random) < thresholds[index]) {
+                magnetization += p[0] ? -2 : 2;
+                energy += 2 * change;
+                setSpin(padded, L, N, i, static_cast<int8_t>(!p[0]));
+            }
+        }
+    }
+
+    void updateRandomSites(Lattice &lattice, int updates, bool standardIsing,
+                           RandomBuffer::Buffer &random, const std::array<uint32_t, 5> &thresholds,
+                           long long &magnetization, long long &energy) {
+        const int L = lattice.L;
+        const int N = lattice.size;
+        int8_t *padded = lattice.padded.data();
+        for (int k = 0; k < updates; ++k)
+            updateSpin(padded, L, N, static_cast<int>(RandomBuffer::bounded(random, N)), standardIsing, random, thresholds,
+                       magnetization, energy);
+    }
+
+    void updateAllSites(Lattice &lattice, bool standardIsing,
+                        RandomBuffer::Buffer &random, const std::array<uint32_t, 5> &thresholds,
+                        long long &magnetization, long long &energy) {
+        /** Typewriter sweep */
+        const int L = lattice.L;
+        const int N = lattice.size;
+        int8_t *padded = lattice.padded.data();
+        for (int i = 0; i < N; ++i)
+            updateSpin(padded, L, N, i, standardIsing, random, thresholds, magnetization, energy);
+    }
+}
@@ -0,0 +1,46 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_HELICAL_H
+#define ISING2021_HELICAL_H
+
+#include "Utils.h"
+#include "RandomBuffer.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace Helical {
+    /**
+     * Helical boundaries: the lattice is one spiral of N = L*L sites and the neighbours of i are
+     * (i +- 1) mod N and (i +- L) mod N. The spins are kept in a flat array with L ghost sites on both ends,
+     * padded[L + i] = spin i, padded[g] = spin N - L + g, padded[N + L + g] = spin g,
+     * so the neighbours of the site p are p +- 1 and p +- L without any table or wrap-around.
+     * Works for both representations: {-1,1} or {0,1} stored as int8.
+     */
+    struct Lattice {
+        int L{};
+        int size{};
+        std::vector<int8_t> padded;
+    };
+
+    void init(Lattice &lattice, int L);
+    void load(Lattice &lattice, const std::vector<int> &spins);
+    void load(Lattice &lattice, const std::vector<bool> &spins);
+    void store(const Lattice &lattice, std::vector<int> &spins);
+    void store(const Lattice &lattice, std::vector<bool> &spins);
+
+    // Same acceptance rules (and consumption of random words) as the buffered MetropolisRSU / BoolSpinConfigurations kernels,
+    // magnetization and energy ({-1,1} mapping) are updated with every accepted flip
+    void updateRandomSites(Lattice &lattice, int updates, bool standardIsing,
+                           RandomBuffer::Buffer &random, const std::array<uint32_t, 5> &thresholds,
+                           long long &magnetization, long long &energy);
+    void updateAllSites(Lattice &lattice, bool standardIsing,
+                        RandomBuffer::Buffer &random, const std::array<uint32_t, 5> &thresholds,
+                        long long &magnetization, long long &energy);
+}
+
+
+#endif //ISING2021_HELICAL_H
@@ -0,0 +1,102 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_LATTICE_H
+#define ISING2021_LATTICE_H
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+
+namespace Lattice {
+    /**
+     * Geometry of the square L x L lattice for the single-spin kernels.
+     * Every geometry answers right/left/up/down(i) (the same as next/previous/up/down[i] from initNeighbors)
+     * and has size; the kernels are templates over it, so for a compile-time L the neighbours are computed
+     * arithmetically (bit masks when L is a power of two) instead of being read from four index tables.
+     */
+
+    struct Periodic {
+        /** Periodic boundaries, identical to initNeighbors */
+        template<int L>
+        static constexpr int right(int i) {
+            if constexpr ((L & (L - 1)) == 0)
+                return (i & ~(L - 1)) | ((i + 1) & (L - 1));
+            else
+                return i % L == L - 1 ? i - (L - 1) : i + 1;
+        }
+
+        template<int L>
+        static constexpr int left(int i) {
+            if constexpr ((L & (L - 1)) == 0)
+                return (i & ~(L - 1)) | ((i - 1) & (L - 1));
+            else
+                return i % L == 0 ? i + (L - 1) : i - 1;
+        }
+
+        template<int L>
+        static constexpr int up(int i) {
+            if constexpr ((L & (L - 1)) == 0)
+                return (i - L) & (L * L - 1);
+            else
+                return i < L ? i + L * (L - 1) : i - L;
+        }
+
+        template<int L>
+        static constexpr int down(int i) {
+            if constexpr ((L & (L - 1)) == 0)
+                return (i + L) & (L * L - 1);
+            else
+                return i >= L * (L - 1) ? i - L * (L - 1) : i + L;
+        }
+    };
+
+    template<int L, typename Boundary = Periodic>
+    struct Fixed {
+        static constexpr int length = L;
+        static constexpr int size = L * L;
+
+        static constexpr int right(int i) { return Boundary::template right<L>(i); }
+        static constexpr int left(int i) { return Boundary::template left<L>(i); }
+        static constexpr int up(int i) { return Boundary::template up<L>(i); }
+        static constexpr int down(int i) { return Boundary::template down<L>(i); }
+    };
+
+    struct Tables {
+        /** Fallback for the sizes without a specialization: neighbour tables of initNeighbors (or any other) */
+        const std::vector<int> &next;
+        const std::vector<int> &previous;
+        const std::vector<int> &upper;
+        const std::vector<int> &lower;
+        int size;
+
+        int right(int i) const { return next[i]; }
+        int left(int i) const { return previous[i]; }
+        int up(int i) const { return upper[i]; }
+        int down(int i) const { return lower[i]; }
+    };
+
+    // Lattice sizes generated in production, each one gets its own instantiation of the kernels
+    using ProductionSizes = std::integer_sequence<int, 10, 16, 20, 30, 32, 40, 50, 60, 64, 100, 128, 256>;
+
+    template<typename Boundary, typename Visitor, int... Ls>
+    bool visitFixed(int L, Visitor &&visit, std::integer_sequence<int, Ls...>) {
+        return ((L == Ls ? (visit(Fixed<Ls, Boundary>{}), true) : false) || ...);
+    }
+
+    template<typename Boundary = Periodic, typename Visitor>
+    void visit(int size, const Tables &tables, Visitor &&visit) {
+        /**
+         * Call visit(geometry) with the compile-time lattice of this size if there is one,
+         * otherwise with the neighbour tables. Both produce exactly the same trajectory.
+         */
+        const int L = static_cast<int>(std::lround(std::sqrt(static_cast<double>(size))));
+        if (L * L != size || !visitFixed<Boundary>(L, visit, ProductionSizes{}))
+            visit(tables);
+    }
+}
+
+
+#endif //ISING2021_LATTICE_H
@@ -3,6 +3,7 @@
 //
 
 #include "Models.h"
+#include "Lattice.h"
 
 
 
@@ -19,7 +20,7 @@ void writeSingleConfiguration(const std::vector<int> &spins, const std::string &
     file.close();
 }
 
-void writeConfigurations(const std::vector<int> &spins, double T, std::ofstream &file, const std::string &separator){
+void writeConfigurations(const std::vector<int> &spins, double T, std::ostream &file, const std::string &separator){
     /**
      * Write only spin configurations for given temperature in one row
      */
@@ -32,7 +33,7 @@ void writeConfigurations(const std::vector<int> &spins, double T, std::ofstream
 void writeData(const std::vector<int> &spins,
                double magnetization,
                double T,
-               std::ofstream &file,
+               std::ostream &file,
                const std::string &separator){
     /**
      * write data in the following configuration:
@@ -44,6 +45,32 @@ void writeData(const std::vector<int> &spins,
     file << "\n";
 }
 
+template<typename Spin>
+static void writeSummary(const std::vector<Spin> &spins,
+                         const Observables::Summary &observables,
+                         double T,
+                         std::ostream &file,
+                         const std::string &separator) {
+    /**
+     * write data with the observables collected during the run:
+     * T <sep> <|m|> <sep> <e> <sep> chi <sep> Cv <sep> U <sep> spin[i]...spin[size] \n
+     */
+    file << T << separator << observables.absMagnetization << separator << observables.energy << separator
+         << observables.susceptibility << separator << observables.specificHeat << separator
+         << observables.binder << separator;
+    for (const auto &spin : spins)
+        file << spin << separator;
+    file << "\n";
+}
+
+void writeData(const std::vector<int> &spins,
+               const Observables::Summary &observables,
+               double T,
+               std::ostream &file,
+               const std::string &separator){
+    writeSummary(spins, observables, T, file, separator);
+}
+
 
 void initNeighbors(std::vector<int> &Right,
                    std::vector<int> &Left,
@@ -99,6 +126,168 @@ void initNeighbors(std::vector<int> &Right,
     }
 }
 
+void initHelicalNeighbors(std::vector<int> &Right,
+                          std::vector<int> &Left,
+                          std::vector<int> &Up,
+                          std::vector<int> &Down,
+                          int L) {
+    /**
+     * Helical boundary conditions: the rows are joined into one spiral,
+     * the last site of a row is followed by the first site of the next one.
+     * -> Right[i] = (i + 1) mod N, Left[i] = (i - 1) mod N
+     * -> Up[i] = (i - L) mod N, Down[i] = (i + L) mod N
+     * Used by the engines that keep neighbour tables (Wolff, Swendsen-Wang, replicas), so that every
+     * engine sees the same lattice as the ghost-padded single-spin kernels in Helical.
+     */
+    int size = L*L;
+
+    for (int i = 0; i < size; ++i) {
+        Right[i] = (i + 1) % size;
+        Left[i] = (i - 1 + size) % size;
+        Up[i] = (i - L + size) % size;
+        Down[i] = (i + L) % size;
+    }
+}
+
+RunningTotals countTotals(const std::vector<int> &spins, const std::vector<int> &next, const std::vector<int> &down) {
+    /** Full-lattice M and E (every bond counted once through the right and lower neighbour) */
+    RunningTotals totals;
+    const int size = static_cast<int>(spins.size());
+    for (int i = 0; i < size; ++i) {
+        totals.magnetization += spins[i];
+        totals.energy -= spins[i] * (spins[next[i]] + spins[down[i]]);
+    }
+    return totals;
+}
+
+RunningTotals countTotals(const std::vector<bool> &spins, const std::vector<int> &next, const std::vector<int> &down) {
+    /** Same for the bool {0,1} spins in the {-1,1} mapping s = 2b - 1 */
+    RunningTotals totals;
+    const int size = static_cast<int>(spins.size());
+    for (int i = 0; i < size; ++i) {
+        const int s = 2 * spins[i] - 1;
+        totals.magnetization += s;
+        totals.energy -= s * ((2 * spins[next[i]] - 1) + (2 * spins[down[i]] - 1));
+    }
+    return totals;
+}
+
+SweepType parseSweepType(const std::string &name) {
+    /** Helper for reading the sweep type from the command line */
+    if (name == "checkerboard")
+        return SweepType::Checkerboard;
+    if (name == "multispin")
+        return SweepType::MultiSpin;
+    if (name == "wolff")
+        return SweepType::Wolff;
+    if (name == "sw")
+        return SweepType::SwendsenWang;
+    if (name == "nfold")
+        return SweepType::NFold;
+    if (name != "rsu")
+        std::cerr << "Unknown sweep type '" << name << "', using random sequential updating\n";
+    return SweepType::RandomSequential;
+}
+
+SweepType selectSweep(SweepType base, double T, double wolffWindow, double nfoldBelow) {
+    /**
+     * Cluster updates are used only within wolffWindow around Tc, where single-spin updates slow down,
+     * the rejection-free n-fold way below nfoldBelow, where almost every Metropolis attempt is rejected
+     */
+    if (wolffWindow > 0.0 && std::abs(T - criticalTemperature) <= wolffWindow)
+        return SweepType::Wolff;
+    if (T < nfoldBelow)
+        return SweepType::NFold;
+    return base;
+}
+
+Boundary parseBoundary(const std::string &name) {
+    /** Helper for reading the boundary conditions from the command line */
+    if (name == "helical")
+        return Boundary::Helical;
+    if (name != "periodic")
+        std::cerr << "Unknown boundary '" << name << "', using periodic boundaries\n";
+    return Boundary::Periodic;
+}
+
+std::string sweepSummary(const SweepEngine &engine) {
+    /** Statistics of the last simulation printed next to the temperature */
+    std::ostringstream summary;
+    if (engine.type == SweepType::Wolff)
+        summary << " <cluster>=" << Wolff::meanClusterSize(engine.cluster);
+    if (engine.type == SweepType::SwendsenWang)
+        summary << " <clusters>=" << SwendsenWang::meanClusters(engine.swendsenWang);
+    if (engine.type == SweepType::NFold)
+        summary << " <flips>=" << NFold::flipsPerStep(engine.nfold);
+    if (engine.warmup.automatic)
+        summary << " equilibration=" << engine.warmup.steps << (engine.warmup.converged ? "" : " (limit)");
+    return summary.str();
+}
+
+std::string samplingSummary(const Autocorrelation::Sampler &sampler) {
+    /** tau_int and the production sweeps of the last simulation, empty for the fixed takeEvery and MCS */
+    if (sampler.spacing <= 0.0 && !Autocorrelation::controlled(sampler))
+        return "";
+    std::ostringstream summary;
+    summary << " tau_int=" << sampler.tau << " sweeps=" << sampler.sweeps;
+    if (sampler.pilot > 0)
+        summary << " pilot=" << sampler.pilot;
+    if (Autocorrelation::controlled(sampler))
+        summary << " ESS=" << Autocorrelation::effectiveSamples(sampler) << " err(|m|)=" << Autocorrelation::error(sampler);
+    return summary.str();
+}
+
+static void beginWarmup(SweepEngine &engine) {
+    /** Automatic thermalization: one Wolff cluster per step until the cluster size is known */
+    Equilibration::reset(engine.warmup);
+    if (engine.type == SweepType::Wolff) {
+        engine.cluster.clustersPerStep = 1;
+        Wolff::resetStatistics(engine.cluster);
+    }
+}
+
+static void endWarmup(SweepEngine &engine, int size) {
+    /** Same state of the statistics as after the engines' own thermalize */
+    if (engine.type == SweepType::Wolff)
+        Wolff::calibrate(engine.cluster, size);
+    if (engine.type == SweepType::SwendsenWang) {
+        engine.swendsenWang.clusters = 0;
+        engine.swendsenWang.steps = 0;
+    }
+}
+
+template<typename Step>
+static double controlledProduction(int size,
+                                   int takeEvery,
+                                   Observables::Accumulator &observables,
+                                   Autocorrelation::Sampler &sampler,
+                                   Step step) {
+    /**
+     * Production of a controlled sampler (target ESS or error bar) for both spin types:
+     * every step feeds tau_int, the samples are still taken every takeEvery steps.
+     * step(m) makes one monte carlo step and returns the totals of the new state.
+     * Returns the average |m| of the samples, like the fixed-MCS loop of simulate.
+     */
+    Autocorrelation::reset(sampler);
+    double magnetizations = 0.0;
+    long long samples = 0;
+    for (int i = 0; ; ++i) {
+        double m;
+        const RunningTotals totals = step(m);
+        const double magnetization = static_cast<double>(totals.magnetization) / size;
+        const double energy = static_cast<double>(totals.energy) / size;
+        Autocorrelation::add(sampler, std::abs(magnetization), energy);
+        if (i % takeEvery == 0) {
+            magnetizations += std::abs(m);
+            ++samples;
+            Observables::add(observables, magnetization, energy);
+        }
+        if (Autocorrelation::finished(sampler))
+            break;
+    }
+    return magnetizations / static_cast<double>(samples);
+}
+
 namespace MetropolisRSU {
 /** ************************************************************************
  *
@@ -243,6 +432,283 @@ namespace MetropolisRSU {
         }
     }
 
+    template<typename Geometry>
+    static void updateSpin(const Geometry &lattice,
+                           int position,
+                           std::vector<int> &spins,
+                           RandomBuffer::Buffer &random,
+                           const std::array<uint32_t, 5> &thresholds,
+                           RunningTotals &totals) {
+        /**
+         *  make update of the spin: dE <= 0 always, otherwise raw random word < thresholds[(dE + 8) / 4]
+         *  an accepted flip changes M by -2s and E by dE
+         */
+        const int dE = 2 * spins[position] * (spins[lattice.left(position)] + spins[lattice.right(position)] +
+                                              spins[lattice.up(position)] + spins[lattice.down(position)]);
+        if (dE <= 0 || RandomBuffer::next(random) < thresholds[(dE + 8) >> 2]) {
+            totals.magnetization -= 2 * spins[position];
+            totals.energy += dE;
+            spins[position] = -spins[position];
+        }
+    }
+
+    template<typename Geometry>
+    static void updateRandomSites(const Geometry &lattice,
+                                  int updates,
+                                  std::vector<int> &spins,
+                                  RandomBuffer::Buffer &random,
+                                  const std::array<uint32_t, 5> &thresholds,
+                                  RunningTotals &totals) {
+        for (int i = 0; i < updates; ++i)
+            updateSpin(lattice, static_cast<int>(RandomBuffer::bounded(random, lattice.size)), spins, random, thresholds, totals);
+    }
+
+    void updateSpin(int position,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds) {
+        const Lattice::Tables tables{next, previous, up, down, static_cast<int>(spins.size())};
+        RunningTotals untracked;
+        updateSpin(tables, position, spins, random, thresholds, untracked);
+    }
+
+    void
+    monteCarloStep(int size,
+                   std::vector<int> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds,
+                   double &m) {
+        /**
+         * Random sequential update, the magnetization is taken after the whole step
+         */
+        monteCarloStep(size, spins, next, previous, up, down, random, thresholds);
+        m = 0.0;
+        for (const auto &spin : spins)
+            m += spin;
+        m = m/size;
+    }
+
+    void
+    monteCarloStep(int size,
+                   std::vector<int> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds) {
+        const Lattice::Tables tables{next, previous, up, down, size};
+        RunningTotals untracked;
+        updateRandomSites(tables, size, spins, random, thresholds, untracked);
+    }
+
+    void thermalize(std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds) {
+        const Lattice::Tables tables{next, previous, up, down, static_cast<int>(spins.size())};
+        RunningTotals untracked;
+        updateRandomSites(tables, warmingTime, spins, random, thresholds, untracked);
+    }
+
+    static void updateRandomSites(SweepEngine &engine,
+                                  int updates,
+                                  std::vector<int> &spins,
+                                  const std::vector<int> &next,
+                                  const std::vector<int> &previous,
+                                  const std::vector<int> &up,
+                                  const std::vector<int> &down) {
+        /**
+         * Single-spin updates of SweepType::RandomSequential: the ghost-padded helical lattice, or the
+         * compile-time periodic lattice of this size if there is one (see Lattice::ProductionSizes),
+         * or the neighbour tables
+         */
+        if (engine.boundary == Boundary::Helical) {
+            Helical::updateRandomSites(engine.helical, updates, true, engine.random, engine.thresholds,
+                                       engine.totals.magnetization, engine.totals.energy);
+            return;
+        }
+        const int size = static_cast<int>(spins.size());
+        const Lattice::Tables tables{next, previous, up, down, size};
+        Lattice::visit(size, tables, [&](const auto &lattice) {
+            updateRandomSites(lattice, updates, spins, engine.random, engine.thresholds, engine.totals);
+        });
+    }
+
+    void prepare(SweepEngine &engine,
+                 const std::vector<int> &spins,
+                 const std::vector<int> &next,
+                 const std::vector<int> &down,
+                 const std::array<double, 5> &boltzmannCoeffs,
+                 pcg64 &rng) {
+        /** Copy the initial state (and coefficients) to the storage of the selected engine */
+        if (engine.type == SweepType::RandomSequential) {
+            RandomBuffer::seed(engine.random, rng);
+            engine.thresholds = RandomBuffer::calculateThresholds(boltzmannCoeffs);
+            engine.totals = countTotals(spins, next, down);
+            if (engine.boundary == Boundary::Helical)
+                Helical::load(engine.helical, spins);
+        }
+        if (engine.type == SweepType::Checkerboard) {
+            Checkerboard::load(engine.checkerboard, spins);
+            engine.checkerboard.thresholds = Checkerboard::calculateThresholds(boltzmannCoeffs);
+            Checkerboard::setKey(engine.checkerboard, rng);
+        }
+        if (engine.type == SweepType::Wolff) {
+            Wolff::setTemperature(engine.cluster, boltzmannCoeffs);
+            Wolff::resetStatistics(engine.cluster);
+            Wolff::load(engine.cluster, spins);
+        }
+        if (engine.type == SweepType::SwendsenWang) {
+            SwendsenWang::load(engine.swendsenWang, spins);
+            SwendsenWang::setTemperature(engine.swendsenWang, boltzmannCoeffs, rng);
+        }
+        if (engine.type == SweepType::NFold) {
+            NFold::load(engine.nfold, spins);
+            NFold::setTemperature(engine.nfold, boltzmannCoeffs, rng);
+        }
+    }
+
+    void synchronize(const SweepEngine &engine, std::vector<int> &spins) {
+        /** Copy the current state of the selected engine back to the row-major spins */
+        if (engine.type == SweepType::RandomSequential && engine.boundary == Boundary::Helical)
+            Helical::store(engine.helical, spins);
+        if (engine.type == SweepType::Checkerboard)
+            Checkerboard::store(engine.checkerboard, spins);
+        if (engine.type == SweepType::SwendsenWang)
+            SwendsenWang::store(engine.swendsenWang, spins);
+        if (engine.type == SweepType::NFold)
+            NFold::store(engine.nfold, spins);
+    }
+
+    static RunningTotals sampleTotals(const SweepEngine &engine,
+                                      std::vector<int> &spins,
+                                      const std::vector<int> &next,
+                                      const std::vector<int> &down) {
+        /** M and E of the current state: free for the single-spin updates, one lattice pass for the other engines */
+        if (engine.type == SweepType::RandomSequential)
+            return engine.totals;
+        if (engine.type == SweepType::NFold)
+            return {engine.nfold.magnetization, engine.nfold.energy};
+        synchronize(engine, spins);
+        return countTotals(spins, next, down);
+    }
+
+    void monteCarloStep(SweepEngine &engine,
+                        int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng,
+                        std::uniform_real_distribution<double> &realDist,
+                        std::uniform_int_distribution<int> &intDist,
+                        double &m) {
+        switch (engine.type) {
+            case SweepType::Checkerboard:
+                Checkerboard::monteCarloStep(engine.checkerboard);
+                m = Checkerboard::magnetization(engine.checkerboard);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::monteCarloStep(engine.swendsenWang, next, previous, up, down);
+                m = SwendsenWang::magnetization(engine.swendsenWang);
+                break;
+            case SweepType::NFold:
+                NFold::monteCarloStep(engine.nfold);
+                m = NFold::magnetization(engine.nfold);
+                break;
+            case SweepType::Wolff:
+                m = static_cast<double>(Wolff::monteCarloStep(engine.cluster, spins, next, previous, up, down,
+                                                              rng, realDist, intDist)) / size;
+                break;
+            default:
+                updateRandomSites(engine, size, spins, next, previous, up, down);
+                m = static_cast<double>(engine.totals.magnetization) / size;
+        }
+    }
+
+    void monteCarloStep(SweepEngine &engine,
+                        int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng,
+                        std::uniform_real_distribution<double> &realDist,
+                        std::uniform_int_distribution<int> &intDist) {
+        switch (engine.type) {
+            case SweepType::Checkerboard:
+                Checkerboard::monteCarloStep(engine.checkerboard);
+                break;
+            case SweepType::Wolff:
+                Wolff::monteCarloStep(engine.cluster, spins, next, previous, up, down, rng, realDist, intDist);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::monteCarloStep(engine.swendsenWang, next, previous, up, down);
+                break;
+            case SweepType::NFold:
+                NFold::monteCarloStep(engine.nfold);
+                break;
+            default:
+                updateRandomSites(engine, size, spins, next, previous, up, down);
+        }
+    }
+
+    void thermalize(SweepEngine &engine,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist) {
+        if (engine.warmup.automatic) {
+            /** Monte carlo steps until |m| and e stop drifting, warmingTime is not used */
+            const int size = static_cast<int>(spins.size());
+            beginWarmup(engine);
+            for (bool done = false; !done;) {
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+                const RunningTotals totals = sampleTotals(engine, spins, next, down);
+                done = Equilibration::add(engine.warmup, std::abs(static_cast<double>(totals.magnetization)) / size,
+                                          static_cast<double>(totals.energy) / size);
+            }
+            endWarmup(engine, size);
+            return;
+        }
+        switch (engine.type) {
+            case SweepType::Checkerboard:
+                Checkerboard::thermalize(engine.checkerboard, warmingTime);
+                break;
+            case SweepType::Wolff:
+                Wolff::thermalize(engine.cluster, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::thermalize(engine.swendsenWang, next, previous, up, down, warmingTime);
+                break;
+            case SweepType::NFold:
+                NFold::thermalize(engine.nfold, warmingTime);
+                break;
+            default:
+                updateRandomSites(engine, warmingTime, spins, next, previous, up, down);
+        }
+    }
+
     double
     simulate(int size,
              std::vector<int> &spins,
@@ -257,26 +723,48 @@ namespace MetropolisRSU {
              const std::array<double, 5> &boltzmannCoeffs,
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
-             pcg64 &rng) {
+             pcg64 &rng,
+             SweepEngine &engine,
+             Observables::Accumulator &observables,
+             Autocorrelation::Sampler &sampler) {
         /**
          * The overloaded function for collecting average magnetization for given Temperature --> algorithm ver 2
          * returns average magnetization for given temperature.
+         * The moments of m and e of every sample are collected in observables.
+         * A controlled sampler (target ESS or error bar) replaces MCS by its own number of production steps.
          */
         double m;
         double magnetizations = 0.0;
 
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
+        Observables::reset(observables);
 
         // Prepare equilibrium - thermalize the model
-        thermalize(spins, next, previous, up, down, warmingTime, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
 
-        for (int i = 0; i <= MCS; ++i) {
-            monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs, m);
-            if (i % takeEvery == 0)
-                magnetizations += std::abs(m);
+        if (!Autocorrelation::controlled(sampler)) {
+            for (int i = 0; i <= MCS; ++i) {
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist, m);
+                if (i % takeEvery == 0) {
+                    magnetizations += std::abs(m);
+                    const RunningTotals totals = sampleTotals(engine, spins, next, down);
+                    Observables::add(observables, static_cast<double>(totals.magnetization) / size,
+                                     static_cast<double>(totals.energy) / size);
+                }
+            }
+            synchronize(engine, spins);
+            return magnetizations / (MCS/takeEvery);
         }
-        return magnetizations / (MCS/takeEvery);
+
+        const double average = controlledProduction(size, takeEvery, observables, sampler, [&](double &step) {
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist, step);
+            return sampleTotals(engine, spins, next, down);
+        });
+        synchronize(engine, spins);
+        return average;
     }
 
     void
@@ -292,20 +780,24 @@ namespace MetropolisRSU {
              const std::array<double, 5> &boltzmannCoeffs,
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
-             pcg64 &rng) {
+             pcg64 &rng,
+             SweepEngine &engine) {
         /**
          * The overloaded function for generating only configurations --> algorithm ver 2
          * Writes only one configuration after all monte carlo steps
          *
          */
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
 
         // Prepare equilibrium - thermalize the model
-        thermalize(spins, next, previous, up, down, warmingTime, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
 
         for (int i = 0; i <= MCS; ++i)
-            monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+        synchronize(engine, spins);
     }
 
     void
@@ -324,23 +816,59 @@ namespace MetropolisRSU {
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
              pcg64 &rng,
-             std::ofstream &file,
-             const std::string &separator) {
+             std::ostream &file,
+             const std::string &separator,
+             SweepEngine &engine,
+             Autocorrelation::Sampler &sampler) {
         /**
          * The overloaded function for generating only configurations --> algorithm ver 2
-         * Writes configurations sampled by monte carlo steps
+         * Writes configurations sampled by monte carlo steps,
+         * every takeEvery steps or (sampler.spacing > 0) spaced by a multiple of the online tau_int
          *
          */
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
 
         // Prepare equilibrium - thermalize the model
-        thermalize(spins, next, previous, up, down, warmingTime, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
 
-        for (int i = 0; i <= MCS; ++i){
-            monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
-            if (i % takeEvery == 0) {
-                writeConfigurations(spins, T, file, separator);
+        if (sampler.spacing <= 0.0) {
+            for (int i = 0; i <= MCS; ++i){
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+                if (i % takeEvery == 0) {
+                    synchronize(engine, spins);
+                    Pipeline::write(engine.output, spins, T, file, separator);
+                }
+            }
+            synchronize(engine, spins);
+            sampler.sweeps = MCS + 1;
+            return;
+        }
+
+        // Adaptive spacing: the same number of configurations, spaced by sampler.spacing * tau_int sweeps,
+        // tau_int is measured on the thermalized chain before the first one is written
+        Autocorrelation::reset(sampler);
+        auto step = [&]() {
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+            const RunningTotals totals = sampleTotals(engine, spins, next, down);
+            Autocorrelation::add(sampler, std::abs(static_cast<double>(totals.magnetization)) / size,
+                                 static_cast<double>(totals.energy) / size);
+        };
+        do
+            step();
+        while (!Autocorrelation::calibrated(sampler));
+        const int samples = MCS / takeEvery + 1;
+        int gap = Autocorrelation::interval(sampler);
+        for (int written = 0, since = 0; written < samples;) {
+            step();
+            if (++since >= gap) {
+                synchronize(engine, spins);
+                Pipeline::write(engine.output, spins, T, file, separator);
+                ++written;
+                since = 0;
+                gap = Autocorrelation::interval(sampler);
             }
         }
     }
@@ -492,6 +1020,322 @@ namespace BoolSpinConfigurations {
         }
     }
 
+    template<typename Geometry>
+    static void updateSpin(const Geometry &lattice,
+                           int position,
+                           std::vector<bool> &spins,
+                           RandomBuffer::Buffer &random,
+                           const std::array<uint32_t, 5> &thresholds,
+                           RunningTotals &totals) {
+        /**
+         * change <= 0 (index <= 2) always, otherwise raw random word < thresholds[index]
+         * change = dE / 2 in the {-1,1} mapping, an accepted flip changes M by -+2 and E by 2 * change
+         */
+        const int sumE = spins[lattice.left(position)] + spins[lattice.right(position)] +
+                         spins[lattice.up(position)] + spins[lattice.down(position)];
+        const int change = spins[position] ? 2 * sumE - 4 : 4 - 2*sumE;
+        const int index = (change + 4) / 2;
+        if (index <= 2 || RandomBuffer::next(random) < thresholds[index]) {
+            totals.magnetization += spins[position] ? -2 : 2;
+            totals.energy += 2 * change;
+            spins[position] = !spins[position];
+        }
+    }
+
+    template<typename Geometry>
+    static void updateRandomSites(const Geometry &lattice,
+                                  int updates,
+                                  std::vector<bool> &spins,
+                                  RandomBuffer::Buffer &random,
+                                  const std::array<uint32_t, 5> &thresholds,
+                                  RunningTotals &totals) {
+        for (int i = 0; i < updates; ++i)
+            updateSpin(lattice, static_cast<int>(RandomBuffer::bounded(random, lattice.size)), spins, random, thresholds, totals);
+    }
+
+    template<typename Geometry>
+    static void updateAllSites(const Geometry &lattice,
+                               std::vector<bool> &spins,
+                               RandomBuffer::Buffer &random,
+                               const std::array<uint32_t, 5> &thresholds,
+                               RunningTotals &totals) {
+        /** Typewriter sweep */
+        for (int position = 0; position < lattice.size; ++position)
+            updateSpin(lattice, position, spins, random, thresholds, totals);
+    }
+
+    void updateSpin(int position,
+                    std::vector<bool> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds) {
+        const Lattice::Tables tables{next, previous, up, down, static_cast<int>(spins.size())};
+        RunningTotals untracked;
+        updateSpin(tables, position, spins, random, thresholds, untracked);
+    }
+
+    void
+    monteCarloStep(int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds,
+                   double &m) {
+        /**
+         * The metropolis algorithm version 1: Iterate over all elements
+         * Calculate magnetization of the system: a site is not visited again after its update,
+         * so its final value is summed right there
+         */
+        const Lattice::Tables tables{next, previous, up, down, size};
+        RunningTotals untracked;
+        long long magnetization = 0;
+        for (int position = 0; position < size; ++position) {
+            updateSpin(tables, position, spins, random, thresholds, untracked);
+            magnetization += spins[position] ? 1 : -1;
+        }
+        m = static_cast<double>(magnetization) / size;
+    }
+
+    void
+    monteCarloStep(int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds) {
+        /**
+         * The metropolis algorithm version 2: Random Sequential updating
+         */
+        const Lattice::Tables tables{next, previous, up, down, size};
+        RunningTotals untracked;
+        updateRandomSites(tables, size, spins, random, thresholds, untracked);
+    }
+
+    void
+    thermalize(int warmingTime,
+               std::vector<bool> &spins,
+               const std::vector<int> &next,
+               const std::vector<int> &previous,
+               const std::vector<int> &up,
+               const std::vector<int> &down,
+               RandomBuffer::Buffer &random,
+               const std::array<uint32_t, 5> &thresholds) {
+        const Lattice::Tables tables{next, previous, up, down, static_cast<int>(spins.size())};
+        RunningTotals untracked;
+        updateRandomSites(tables, warmingTime, spins, random, thresholds, untracked);
+    }
+
+    static void updateRandomSites(SweepEngine &engine,
+                                  int updates,
+                                  std::vector<bool> &spins,
+                                  const std::vector<int> &next,
+                                  const std::vector<int> &previous,
+                                  const std::vector<int> &up,
+                                  const std::vector<int> &down) {
+        /** Random sequential updates of SweepType::RandomSequential, see MetropolisRSU::updateRandomSites */
+        if (engine.boundary == Boundary::Helical) {
+            Helical::updateRandomSites(engine.helical, updates, false, engine.random, engine.thresholds,
+                                       engine.totals.magnetization, engine.totals.energy);
+            return;
+        }
+        const int size = static_cast<int>(spins.size());
+        const Lattice::Tables tables{next, previous, up, down, size};
+        Lattice::visit(size, tables, [&](const auto &lattice) {
+            updateRandomSites(lattice, updates, spins, engine.random, engine.thresholds, engine.totals);
+        });
+    }
+
+    static void updateAllSites(SweepEngine &engine,
+                               std::vector<bool> &spins,
+                               const std::vector<int> &next,
+                               const std::vector<int> &previous,
+                               const std::vector<int> &up,
+                               const std::vector<int> &down) {
+        /** Typewriter sweep of SweepType::RandomSequential */
+        if (engine.boundary == Boundary::Helical) {
+            Helical::updateAllSites(engine.helical, false, engine.random, engine.thresholds,
+                                    engine.totals.magnetization, engine.totals.energy);
+            return;
+        }
+        const int size = static_cast<int>(spins.size());
+        const Lattice::Tables tables{next, previous, up, down, size};
+        Lattice::visit(size, tables, [&](const auto &lattice) {
+            updateAllSites(lattice, spins, engine.random, engine.thresholds, engine.totals);
+        });
+    }
+
+    void prepare(SweepEngine &engine,
+                 const std::vector<bool> &spins,
+                 const std::vector<int> &next,
+                 const std::vector<int> &down,
+                 const std::array<double, 5> &boltzmannCoeffs,
+                 pcg64 &rng) {
+        /** Copy the initial state (and coefficients) to the storage of the selected engine */
+        if (engine.type == SweepType::RandomSequential) {
+            RandomBuffer::seed(engine.random, rng);
+            engine.thresholds = RandomBuffer::calculateThresholds(boltzmannCoeffs);
+            engine.totals = countTotals(spins, next, down);
+            if (engine.boundary == Boundary::Helical)
+                Helical::load(engine.helical, spins);
+        }
+        if (engine.type == SweepType::MultiSpin) {
+            MultiSpin::pack(engine.multiSpin, spins);
+            MultiSpin::setThresholds(engine.multiSpin, boltzmannCoeffs);
+        }
+        if (engine.type == SweepType::Wolff) {
+            Wolff::setTemperature(engine.cluster, boltzmannCoeffs);
+            Wolff::resetStatistics(engine.cluster);
+            Wolff::load(engine.cluster, spins);
+        }
+        if (engine.type == SweepType::SwendsenWang) {
+            SwendsenWang::load(engine.swendsenWang, spins);
+            SwendsenWang::setTemperature(engine.swendsenWang, boltzmannCoeffs, rng);
+        }
+        if (engine.type == SweepType::NFold) {
+            NFold::load(engine.nfold, spins);
+            NFold::setTemperature(engine.nfold, boltzmannCoeffs, rng);
+        }
+    }
+
+    void synchronize(const SweepEngine &engine, std::vector<bool> &spins) {
+        /** Copy the current state of the selected engine back to the row-major spins */
+        if (engine.type == SweepType::RandomSequential && engine.boundary == Boundary::Helical)
+            Helical::store(engine.helical, spins);
+        if (engine.type == SweepType::MultiSpin)
+            MultiSpin::unpack(engine.multiSpin, spins);
+        if (engine.type == SweepType::SwendsenWang)
+            SwendsenWang::store(engine.swendsenWang, spins);
+        if (engine.type == SweepType::NFold)
+            NFold::store(engine.nfold, spins);
+    }
+
+    static RunningTotals sampleTotals(const SweepEngine &engine,
+                                      std::vector<bool> &spins,
+                                      const std::vector<int> &next,
+                                      const std::vector<int> &down) {
+        /** M and E of the current state: free for the single-spin updates, one lattice pass for the other engines */
+        if (engine.type == SweepType::RandomSequential)
+            return engine.totals;
+        if (engine.type == SweepType::NFold)
+            return {engine.nfold.magnetization, engine.nfold.energy};
+        synchronize(engine, spins);
+        return countTotals(spins, next, down);
+    }
+
+    void
+    monteCarloStep(SweepEngine &engine,
+                   int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   pcg64 &rng,
+                   std::uniform_real_distribution<double> &realDist,
+                   std::uniform_int_distribution<int> &intDist,
+                   double &m) {
+        switch (engine.type) {
+            case SweepType::MultiSpin:
+                MultiSpin::monteCarloStep(engine.multiSpin, rng);
+                m = MultiSpin::magnetization(engine.multiSpin);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::monteCarloStep(engine.swendsenWang, next, previous, up, down);
+                m = SwendsenWang::magnetization(engine.swendsenWang);
+                break;
+            case SweepType::NFold:
+                NFold::monteCarloStep(engine.nfold);
+                m = NFold::magnetization(engine.nfold);
+                break;
+            case SweepType::Wolff:
+                m = static_cast<double>(Wolff::monteCarloStep(engine.cluster, spins, next, previous, up, down,
+                                                              rng, realDist, intDist)) / size;
+                break;
+            default:
+                updateAllSites(engine, spins, next, previous, up, down);
+                m = static_cast<double>(engine.totals.magnetization) / size;
+        }
+    }
+
+    void
+    monteCarloStep(SweepEngine &engine,
+                   int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   pcg64 &rng,
+                   std::uniform_real_distribution<double> &realDist,
+                   std::uniform_int_distribution<int> &intDist) {
+        switch (engine.type) {
+            case SweepType::MultiSpin:
+                MultiSpin::monteCarloStep(engine.multiSpin, rng);
+                break;
+            case SweepType::Wolff:
+                Wolff::monteCarloStep(engine.cluster, spins, next, previous, up, down, rng, realDist, intDist);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::monteCarloStep(engine.swendsenWang, next, previous, up, down);
+                break;
+            case SweepType::NFold:
+                NFold::monteCarloStep(engine.nfold);
+                break;
+            default:
+                updateRandomSites(engine, size, spins, next, previous, up, down);
+        }
+    }
+
+    void
+    thermalize(SweepEngine &engine,
+               int warmingTime,
+               std::vector<bool> &spins,
+               const std::vector<int> &next,
+               const std::vector<int> &previous,
+               const std::vector<int> &up,
+               const std::vector<int> &down,
+               pcg64 &rng,
+               std::uniform_real_distribution<double> &realDist,
+               std::uniform_int_distribution<int> &intDist) {
+        if (engine.warmup.automatic) {
+            /** Monte carlo steps until |m| and e stop drifting, warmingTime is not used */
+            const int size = static_cast<int>(spins.size());
+            beginWarmup(engine);
+            for (bool done = false; !done;) {
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+                const RunningTotals totals = sampleTotals(engine, spins, next, down);
+                done = Equilibration::add(engine.warmup, std::abs(static_cast<double>(totals.magnetization)) / size,
+                                          static_cast<double>(totals.energy) / size);
+            }
+            endWarmup(engine, size);
+            return;
+        }
+        switch (engine.type) {
+            case SweepType::MultiSpin:
+                MultiSpin::thermalize(engine.multiSpin, warmingTime, rng);
+                break;
+            case SweepType::Wolff:
+                Wolff::thermalize(engine.cluster, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
+                break;
+            case SweepType::SwendsenWang:
+                SwendsenWang::thermalize(engine.swendsenWang, next, previous, up, down, warmingTime);
+                break;
+            case SweepType::NFold:
+                NFold::thermalize(engine.nfold, warmingTime);
+                break;
+            default:
+                updateRandomSites(engine, warmingTime, spins, next, previous, up, down);
+        }
+    }
+
     double
     simulate(std::vector<bool> &spins,
              const std::vector<int> &next,
@@ -506,25 +1350,47 @@ namespace BoolSpinConfigurations {
              int size,
              int MCS,
              int warmingTime,
-             int takeEvery) {
+             int takeEvery,
+             SweepEngine &engine,
+             Observables::Accumulator &observables,
+             Autocorrelation::Sampler &sampler) {
         /**
          * The overloaded function for collecting average magnetization for given Temperature --> algorithm ver 1
+         * The moments of m and e of every sample are collected in observables.
+         * A controlled sampler (target ESS or error bar) replaces MCS by its own number of production steps.
          */
         double m;
         double magnetizations = 0.0;
 
 
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
+        Observables::reset(observables);
 
         // Prepare equilibrium - warmup of the matrix
-        thermalize(warmingTime, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, warmingTime, spins, next, previous, up, down, rng, realDist, intDist);
+        if (!Autocorrelation::controlled(sampler)) {
             for (int i = 0; i <= MCS; ++i) {
-                monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs, m);
-                if (i % takeEvery == 0)
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist, m);
+                if (i % takeEvery == 0) {
                     magnetizations += std::abs(m);
+                    const RunningTotals totals = sampleTotals(engine, spins, next, down);
+                    Observables::add(observables, static_cast<double>(totals.magnetization) / size,
+                                     static_cast<double>(totals.energy) / size);
+                }
             }
+            synchronize(engine, spins);
             return magnetizations / (MCS/takeEvery); // no need explicit casting if MCS and takeEvery are correct
+        }
+
+        const double average = controlledProduction(size, takeEvery, observables, sampler, [&](double &step) {
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist, step);
+            return sampleTotals(engine, spins, next, down);
+        });
+        synchronize(engine, spins);
+        return average;
     }
 
     void
@@ -540,18 +1406,22 @@ namespace BoolSpinConfigurations {
              const std::array<double, 5> &boltzmannCoeffs,
              int size,
              int MCS,
-             int warmingTime) {
+             int warmingTime,
+             SweepEngine &engine) {
         /**
          * The overloaded function that doesnt calculate magnetization --> algorithm ver 2
          */
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
 
         // Prepare equilibrium - warmup of the matrix
-        thermalize(warmingTime, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, warmingTime, spins, next, previous, up, down, rng, realDist, intDist);
 
         for (int i = 0; i <= MCS; ++i)
-            monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+        synchronize(engine, spins);
     }
 
     void
@@ -570,23 +1440,60 @@ namespace BoolSpinConfigurations {
              int warmingTime,
              int takeEvery,
              double T,
-             std::ofstream &file,
-             const std::string &separator) {
+             std::ostream &file,
+             const std::string &separator,
+             SweepEngine &engine,
+             Autocorrelation::Sampler &sampler) {
         /**
          * The overloaded function that doesnt calculate magnetization --> algorithm ver 2
-         * Writes only configrations sampled by MCS
+         * Writes only configrations sampled by MCS,
+         * every takeEvery steps or (sampler.spacing > 0) spaced by a multiple of the online tau_int
          */
         // init
-        initState(spins, rng, choice);
+        if (!engine.warmStart)
+            initState(spins, rng, choice);
 //        std::fill(spins.begin(), spins.end(), 0); // choose this for fixed initial state
+        prepare(engine, spins, next, down, boltzmannCoeffs, rng);
 
         // Prepare equilibrium - warmup of the matrix
-        thermalize(warmingTime, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
+        thermalize(engine, warmingTime, spins, next, previous, up, down, rng, realDist, intDist);
+
+        if (sampler.spacing <= 0.0) {
+            for (int i = 0; i <= MCS; ++i) {
+                monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+                if (i % takeEvery == 0) {
+                    synchronize(engine, spins);
+                    Pipeline::write(engine.output, spins, T, file, separator);
+                }
+            }
+            synchronize(engine, spins);
+            sampler.sweeps = MCS + 1;
+            return;
+        }
 
-        for (int i = 0; i <= MCS; ++i) {
-            monteCarloStep(size, spins, next, previous, up, down, rng, realDist, intDist, boltzmannCoeffs);
-            if (i % takeEvery == 0)
-                writeConfigurations(spins, T, file, separator);
+        // Adaptive spacing: the same number of configurations, spaced by sampler.spacing * tau_int sweeps,
+        // tau_int is measured on the thermalized chain before the first one is written
+        Autocorrelation::reset(sampler);
+        auto step = [&]() {
+            monteCarloStep(engine, size, spins, next, previous, up, down, rng, realDist, intDist);
+            const RunningTotals totals = sampleTotals(engine, spins, next, down);
+            Autocorrelation::add(sampler, std::abs(static_cast<double>(totals.magnetization)) / size,
+                                 static_cast<double>(totals.energy) / size);
+        };
+        do
+            step();
+        while (!Autocorrelation::calibrated(sampler));
+        const int samples = MCS / takeEvery + 1;
+        int gap = Autocorrelation::interval(sampler);
+        for (int written = 0, since = 0; written < samples;) {
+            step();
+            if (++since >= gap) {
+                synchronize(engine, spins);
+                Pipeline::write(engine.output, spins, T, file, separator);
+                ++written;
+                since = 0;
+                gap = Autocorrelation::interval(sampler);
+            }
         }
     }
 
@@ -595,7 +1502,7 @@ namespace BoolSpinConfigurations {
     void writeData(const std::vector<bool> &spins,
                    double magnetization,
                    double T,
-                   std::ofstream &file,
+                   std::ostream &file,
                    const std::string &separator){
         /**
          * write data in the following configuration:
@@ -607,9 +1514,17 @@ namespace BoolSpinConfigurations {
         file << "\n";
     }
 
+    void writeData(const std::vector<bool> &spins,
+                   const Observables::Summary &observables,
+                   double T,
+                   std::ostream &file,
+                   const std::string &separator){
+        writeSummary(spins, observables, T, file, separator);
+    }
+
     void writeConfigurations(const std::vector<bool> &spins,
                              double T,
-                             std::ofstream &file,
+                             std::ostream &file,
                              const std::string &separator){
         /**
          * Write only spin configurations for given temperature in one row
@@ -6,19 +6,89 @@
 #define ISING2021_MODELS_H
 
 #include "Utils.h"
+#include "Checkerboard.h"
+#include "MultiSpin.h"
+#include "Wolff.h"
+#include "SwendsenWang.h"
+#include "NFold.h"
+#include "RandomBuffer.h"
+#include "Helical.h"
+#include "Observables.h"
+#include "Autocorrelation.h"
+#include "Equilibration.h"
+#include "Pipeline.h"
 #include <fstream>
 #include <array>
 #include <vector>
 #include <cmath>
 
 
+enum class SweepType {
+    RandomSequential,   // single-spin updates of randomly chosen sites (default)
+    Checkerboard,       // red/black sublattice updates with SIMD kernels, only for {-1,1} spins and even L
+    MultiSpin,          // bit-packed multi-spin coding, 64 sites per word, only for {0,1} spins and even L
+    Wolff,              // single-cluster updates, both spin representations
+    SwendsenWang,       // multithreaded Swendsen-Wang cluster updates, both spin representations
+    NFold               // rejection-free n-fold way (continuous time), both spin representations
+};
+
+enum class Boundary {
+    Periodic,           // torus, neighbour tables from initNeighbors (default)
+    Helical             // one spiral of L*L sites, neighbours (i +- 1) mod N and (i +- L) mod N
+};
+
+const double criticalTemperature = 2.0 / std::log(1.0 + std::sqrt(2.0));  // Onsager, ~2.269
+
+struct RunningTotals {
+    /**
+     * Observables of the current state in the {-1,1} mapping (bool spins: s = 2b - 1),
+     * updated by the single-spin kernels with every accepted flip
+     */
+    long long magnetization{0};   // sum of the spins
+    long long energy{0};          // -sum over the bonds of s_i * s_j
+};
+
+struct SweepEngine {
+    /**
+     * Selects the way a single monte carlo step is performed inside simulate(...)
+     * and keeps the workspace of the chosen engine between the steps
+     */
+    SweepType type{SweepType::RandomSequential};
+    Checkerboard::Lattice checkerboard;
+    MultiSpin::Lattice multiSpin;
+    Wolff::Cluster cluster;
+    SwendsenWang::Workspace swendsenWang;
+    NFold::Lattice nfold;
+    Boundary boundary{Boundary::Periodic};
+    Helical::Lattice helical;                         // ghost-padded spins of the helical single-spin updates
+    RandomBuffer::Buffer random;                      // raw random words of the single-spin updates
+    std::array<uint32_t, 5> thresholds{};             // integer acceptance thresholds of the single-spin updates
+    RunningTotals totals;                             // M and E of the single-spin updates, valid after prepare
+    Equilibration::Detector warmup;                   // automatic thermalization, otherwise warmingTime updates
+    bool warmStart{false};                            // simulate starts from the given spins instead of initState
+    Pipeline::Producer output;                        // saved configurations, formatted by the sinks if it has a stage
+};
+
+SweepType parseSweepType(const std::string &name);
+SweepType selectSweep(SweepType base, double T, double wolffWindow, double nfoldBelow = 0.0);
+Boundary parseBoundary(const std::string &name);
+std::string sweepSummary(const SweepEngine &engine);
+std::string samplingSummary(const Autocorrelation::Sampler &sampler);
+
+
 void writeSingleConfiguration(const std::vector<int> &spins, const std::string &fileName);
-void writeConfigurations(const std::vector<int> &spins, double T, std::ofstream &file, const std::string &separator);
+void writeConfigurations(const std::vector<int> &spins, double T, std::ostream &file, const std::string &separator);
 
 void writeData(const std::vector<int> &spins,
                double magnetization,
                double T,
-               std::ofstream &file,
+               std::ostream &file,
+               const std::string &separator);
+
+void writeData(const std::vector<int> &spins,
+               const Observables::Summary &observables,
+               double T,
+               std::ostream &file,
                const std::string &separator);
 
 void initNeighbors(std::vector<int> &Right,
@@ -27,6 +97,15 @@ void initNeighbors(std::vector<int> &Right,
                    std::vector<int> &Down,
                    int L);
 
+RunningTotals countTotals(const std::vector<int> &spins, const std::vector<int> &next, const std::vector<int> &down);
+RunningTotals countTotals(const std::vector<bool> &spins, const std::vector<int> &next, const std::vector<int> &down);
+
+void initHelicalNeighbors(std::vector<int> &Right,
+                          std::vector<int> &Left,
+                          std::vector<int> &Up,
+                          std::vector<int> &Down,
+                          int L);
+
 
 namespace MetropolisRSU {
     std::array<double, 5> calculateBoltzmannCoeff(double T);
@@ -78,6 +157,88 @@ namespace MetropolisRSU {
                     std::uniform_real_distribution<double> &realDist,
                     std::uniform_int_distribution<int> &intDist,
                     const std::array<double, 5> &boltzmannCoeffs);
+
+    // Versions with buffered raw random words and integer thresholds (used by SweepType::RandomSequential)
+    void updateSpin(int position,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds);
+
+    void monteCarloStep(int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        RandomBuffer::Buffer &random,
+                        const std::array<uint32_t, 5> &thresholds,
+                        double &m);
+
+    void monteCarloStep(int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        RandomBuffer::Buffer &random,
+                        const std::array<uint32_t, 5> &thresholds);
+
+    void thermalize(std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds);
+
+    // Versions dispatching to the engine selected in SweepEngine, the temperature is set by prepare(...)
+    void prepare(SweepEngine &engine,
+                 const std::vector<int> &spins,
+                 const std::vector<int> &next,
+                 const std::vector<int> &down,
+                 const std::array<double, 5> &boltzmannCoeffs,
+                 pcg64 &rng);
+    void synchronize(const SweepEngine &engine, std::vector<int> &spins);
+
+    void monteCarloStep(SweepEngine &engine,
+                        int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng,
+                        std::uniform_real_distribution<double> &realDist,
+                        std::uniform_int_distribution<int> &intDist,
+                        double &m);
+
+    void monteCarloStep(SweepEngine &engine,
+                        int size,
+                        std::vector<int> &spins,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng,
+                        std::uniform_real_distribution<double> &realDist,
+                        std::uniform_int_distribution<int> &intDist);
+
+    void thermalize(SweepEngine &engine,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist);
+
     double
     simulate(int size,
              std::vector<int> &spins,
@@ -92,7 +253,10 @@ namespace MetropolisRSU {
              const std::array<double, 5> &boltzmannCoeffs,
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
-             pcg64 &rng);
+             pcg64 &rng,
+             SweepEngine &engine,
+             Observables::Accumulator &observables,
+             Autocorrelation::Sampler &sampler);
 
     // This one used only for generating configurations / without calculating m
     void
@@ -107,7 +271,8 @@ namespace MetropolisRSU {
              const std::array<double, 5> &boltzmannCoeffs,
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
-             pcg64 &rng);
+             pcg64 &rng,
+             SweepEngine &engine);
 
     void
     simulate(int size,
@@ -125,8 +290,10 @@ namespace MetropolisRSU {
              std::uniform_int_distribution<int> &choice,
              std::uniform_int_distribution<int> &intDist,
              pcg64 &rng,
-             std::ofstream &file,
-             const std::string &separator);
+             std::ostream &file,
+             const std::string &separator,
+             SweepEngine &engine,
+             Autocorrelation::Sampler &sampler);
 
 }
 
@@ -184,6 +351,94 @@ namespace BoolSpinConfigurations {
                std::uniform_real_distribution<double> &realDist,
                std::uniform_int_distribution<int> &intDist,
                const std::array<double, 5> &boltzmannCoeffs);
+
+    // Versions with buffered raw random words and integer thresholds (used by SweepType::RandomSequential)
+    void updateSpin(int position,
+                    std::vector<bool> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    RandomBuffer::Buffer &random,
+                    const std::array<uint32_t, 5> &thresholds);
+
+    void
+    monteCarloStep(int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds,
+                   double &m);
+
+    void
+    monteCarloStep(int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   RandomBuffer::Buffer &random,
+                   const std::array<uint32_t, 5> &thresholds);
+
+    void
+    thermalize(int warmingTime,
+               std::vector<bool> &spins,
+               const std::vector<int> &next,
+               const std::vector<int> &previous,
+               const std::vector<int> &up,
+               const std::vector<int> &down,
+               RandomBuffer::Buffer &random,
+               const std::array<uint32_t, 5> &thresholds);
+
+    // Versions dispatching to the engine selected in SweepEngine, the temperature is set by prepare(...)
+    void prepare(SweepEngine &engine,
+                 const std::vector<bool> &spins,
+                 const std::vector<int> &next,
+                 const std::vector<int> &down,
+                 const std::array<double, 5> &boltzmannCoeffs,
+                 pcg64 &rng);
+    void synchronize(const SweepEngine &engine, std::vector<bool> &spins);
+
+    void
+    monteCarloStep(SweepEngine &engine,
+                   int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   pcg64 &rng,
+                   std::uniform_real_distribution<double> &realDist,
+                   std::uniform_int_distribution<int> &intDist,
+                   double &m);
+
+    void
+    monteCarloStep(SweepEngine &engine,
+                   int size,
+                   std::vector<bool> &spins,
+                   const std::vector<int> &next,
+                   const std::vector<int> &previous,
+                   const std::vector<int> &up,
+                   const std::vector<int> &down,
+                   pcg64 &rng,
+                   std::uniform_real_distribution<double> &realDist,
+                   std::uniform_int_distribution<int> &intDist);
+
+    void
+    thermalize(SweepEngine &engine,
+               int warmingTime,
+               std::vector<bool> &spins,
+               const std::vector<int> &next,
+               const std::vector<int> &previous,
+               const std::vector<int> &up,
+               const std::vector<int> &down,
+               pcg64 &rng,
+               std::uniform_real_distribution<double> &realDist,
+               std::uniform_int_distribution<int> &intDist);
+
     double
     simulate(std::vector<bool> &spins,
              const std::vector<int> &next,
@@ -198,7 +453,10 @@ namespace BoolSpinConfigurations {
              int size,
              int MCS,
              int warmingTime,
-             int takeEvery);
+             int takeEvery,
+             SweepEngine &engine,
+             Observables::Accumulator &observables,
+             Autocorrelation::Sampler &sampler);
 
     // This one is only for calculating configurations
     void
@@ -214,7 +472,8 @@ namespace BoolSpinConfigurations {
              const std::array<double, 5> &boltzmannCoeffs,
              int size,
              int MCS,
-             int warmingTime);
+             int warmingTime,
+             SweepEngine &engine);
 
     // This one is only for calculating configurations and writing them every some Monte carlo steps
     void
@@ -233,18 +492,26 @@ namespace BoolSpinConfigurations {
              int warmingTime,
              int takeEvery,
              double T,
-             std::ofstream &file,
-             const std::string &separator);
+             std::ostream &file,
+             const std::string &separator,
+             SweepEngine &engine,
+             Autocorrelation::Sampler &sampler);
 
     void writeData(const std::vector<bool> &spins,
                    double magnetization,
                    double T,
-                   std::ofstream &file,
+                   std::ostream &file,
+                   const std::string &separator);
+
+    void writeData(const std::vector<bool> &spins,
+                   const Observables::Summary &observables,
+                   double T,
+                   std::ostream &file,
                    const std::string &separator);
 
     void writeConfigurations(const std::vector<bool> &spins,
                              double T,
-                             std::ofstream &file,
+                             std::ostream &file,
                              const std::string &separator);
 }
 
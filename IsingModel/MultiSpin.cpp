@@ -0,0 +1,152 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "MultiSpin.h"
+#include "RandomBuffer.h"
+#include <bit>
+
+
+namespace MultiSpin {
+/** ************************************************************************
+ *
+ * Multi-spin coded Metropolis for the boolean {0,1} model
+ * Neighbour sums are evaluated with bitwise adder logic for 64 sites at once
+ *
+ * *************************************************************************
+ * */
+
+    bool supports(int L) {
+        return L >= 2 && L % 2 == 0;
+    }
+
+    void init(Lattice &lattice, int L) {
+        lattice.L = L;
+        lattice.words = (L + 63) / 64;
+        lattice.rows.assign(static_cast<size_t>(L) * lattice.words, 0);
+        lattice.left.assign(lattice.words, 0);
+        lattice.right.assign(lattice.words, 0);
+
+        const int tail = L % 64;
+        const uint64_t lastWord = tail ? (uint64_t{1} << tail) - 1 : ~uint64_t{0};
+        for (int p = 0; p < 2; ++p) {
+            lattice.colourMask[p].assign(lattice.words, p ? 0xAAAAAAAAAAAAAAAAull : 0x5555555555555555ull);
+            lattice.colourMask[p].back() &= lastWord;
+        }
+    }
+
+    void pack(Lattice &lattice, const std::vector<bool> &spins) {
+        const int L = lattice.L;
+        std::fill(lattice.rows.begin(), lattice.rows.end(), 0);
+        for (int row = 0; row < L; ++row)
+            for (int j = 0; j < L; ++j)
+                if (spins[row * L + j])
+                    lattice.rows[row * lattice.words + j / 64] |= uint64_t{1} << (j % 64);
+    }
+
+    void unpack(const Lattice &lattice, std::vector<bool> &spins) {
+        const int L = lattice.L;
+        for (int row = 0; row < L; ++row)
+            for (int j = 0; j < L; ++j)
+                spins[row * L + j] = (lattice.rows[row * lattice.words + j / 64] >> (j % 64)) & 1;
+    }
+
+    void setThresholds(Lattice &lattice, const std::array<double, 5> &boltzmannCoeffs) {
+        /** boltzmannCoeffs from BoolSpinConfigurations::calculateBoltzmannCoeff: [3] -> dE = 4, [4] -> dE = 8 */
+        lattice.threshold4 = RandomBuffer::toThreshold(boltzmannCoeffs[3]);
+        lattice.threshold8 = RandomBuffer::toThreshold(boltzmannCoeffs[4]);
+    }
+
+    static void rotateRow(Lattice &lattice, const uint64_t *row) {
+        /**
+         * left[j] = row[j - 1], right[j] = row[j + 1] (periodic in L)
+         */
+        const int W = lattice.words;
+        const int last = lattice.L - 1;
+        for (int w = 0; w < W; ++w) {
+            lattice.left[w] = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+            lattice.right[w] = (row[w] >> 1) | (w + 1 < W ? row[w + 1] << 63 : 0);
+        }
+        const uint64_t lastBit = uint64_t{1} << (last % 64);
+        lattice.left[W - 1] &= lastBit | (lastBit - 1);
+        lattice.left[0] |= (row[last / 64] >> (last % 64)) & 1;
+        lattice.right[last / 64] = (lattice.right[last / 64] & ~lastBit) | ((row[0] & 1) << (last % 64));
+    }
+
+    static void bernoulli(uint64_t need4, uint64_t need8, uint32_t threshold4, uint32_t threshold8,
+                          uint64_t &less4, uint64_t &less8, pcg64 &rng) {
+        /**
+         * Bitwise comparison of a uniform 32-bit number U (one per bit lane) with the thresholds.
+         * Every random word is one bit-plane of U, starting from the most significant bit; a lane is
+         * decided at the first bit where U differs from the threshold, so only a few words are needed.
+         */
+        less4 = 0;
+        less8 = 0;
+        for (int b = 31; b >= 0 && (need4 | need8); --b) {
+            const uint64_t u = rng();
+            const uint64_t t4 = ((threshold4 >> b) & 1) ? ~uint64_t{0} : 0;
+            const uint64_t t8 = ((threshold8 >> b) & 1) ? ~uint64_t{0} : 0;
+            const uint64_t decided4 = need4 & (u ^ t4);
+            const uint64_t decided8 = need8 & (u ^ t8);
+            less4 |= decided4 & t4;
+            less8 |= decided8 & t8;
+            need4 &= ~decided4;
+            need8 &= ~decided8;
+        }
+    }
+
+    void updateColour(Lattice &lattice, int c, pcg64 &rng) {
+        /**
+         * x_i = s ^ neighbour_i marks anti-aligned neighbours, k = x1 + x2 + x3 + x4 (full adders):
+         * k >= 2 -> dE <= 0 always flip, k == 1 -> dE = 4, k == 0 -> dE = 8
+         */
+        const int L = lattice.L;
+        const int W = lattice.words;
+        for (int row = 0; row < L; ++row) {
+            uint64_t *s = &lattice.rows[row * W];
+            const uint64_t *up = &lattice.rows[((row + L - 1) % L) * W];
+            const uint64_t *down = &lattice.rows[((row + 1) % L) * W];
+            const std::vector<uint64_t> &mask = lattice.colourMask[(row + c) & 1];
+            rotateRow(lattice, s);
+
+            for (int w = 0; w < W; ++w) {
+                const uint64_t x1 = s[w] ^ up[w];
+                const uint64_t x2 = s[w] ^ down[w];
+                const uint64_t x3 = s[w] ^ lattice.left[w];
+                const uint64_t x4 = s[w] ^ lattice.right[w];
+
+                const uint64_t sum12 = x1 ^ x2, carry12 = x1 & x2;
+                const uint64_t sum34 = x3 ^ x4, carry34 = x3 & x4;
+                const uint64_t atLeastTwo = carry12 | carry34 | (sum12 & sum34);
+                const uint64_t none = ~(x1 | x2 | x3 | x4);
+                const uint64_t one = ~(atLeastTwo | none);
+
+                uint64_t less4, less8;
+                bernoulli(one & mask[w], none & mask[w], lattice.threshold4, lattice.threshold8, less4, less8, rng);
+                s[w] ^= mask[w] & (atLeastTwo | (one & less4) | (none & less8));
+            }
+        }
+    }
+
+    void monteCarloStep(Lattice &lattice, pcg64 &rng) {
+        updateColour(lattice, 0, rng);
+        updateColour(lattice, 1, rng);
+    }
+
+    void thermalize(Lattice &lattice, int warmingTime, pcg64 &rng) {
+        /** warmingTime is given in single-spin updates, as in BoolSpinConfigurations::thermalize */
+        const int size = lattice.L * lattice.L;
+        const int sweeps = (warmingTime + size - 1) / size;
+        for (int k = 0; k < sweeps; ++k)
+            monteCarloStep(lattice, rng);
+    }
+
+    double magnetization(const Lattice &lattice) {
+        /** Same convention as BoolSpinConfigurations: m = (2 * #up - size) / size */
+        long long up = 0;
+        for (const auto &word : lattice.rows)
+            up += std::popcount(word);
+        const double size = static_cast<double>(lattice.L) * lattice.L;
+        return (2.0 * up - size) / size;
+    }
+}
@@ -0,0 +1,46 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_MULTISPIN_H
+#define ISING2021_MULTISPIN_H
+
+#include "Utils.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace MultiSpin {
+    /**
+     * Bit-packed storage of the boolean {0,1} lattice (multi-spin coding).
+     * Bit j % 64 of rows[row * words + j / 64] holds the spin (row, j); unused bits of the last word stay 0.
+     * Sites with (row + j) % 2 == c form the colour c, so 32 sites of one colour are updated by one word operation.
+     * Works only for even L.
+     */
+    struct Lattice {
+        int L{};
+        int words{};                                  // words per row
+        std::vector<uint64_t> rows;
+        std::array<std::vector<uint64_t>, 2> colourMask;  // colourMask[p][w]: sites with column parity p
+        std::vector<uint64_t> left;                   // left neighbours of the current row
+        std::vector<uint64_t> right;                  // right neighbours of the current row
+        uint32_t threshold4{};                        // acceptance threshold (of 2^32) for dE = 4
+        uint32_t threshold8{};                        // acceptance threshold (of 2^32) for dE = 8
+    };
+
+    bool supports(int L);
+    void init(Lattice &lattice, int L);
+    void pack(Lattice &lattice, const std::vector<bool> &spins);
+    void unpack(const Lattice &lattice, std::vector<bool> &spins);
+
+    void setThresholds(Lattice &lattice, const std::array<double, 5> &boltzmannCoeffs);
+
+    void updateColour(Lattice &lattice, int c, pcg64 &rng);
+    void monteCarloStep(Lattice &lattice, pcg64 &rng);
+    void thermalize(Lattice &lattice, int warmingTime, pcg64 &rng);
+    double magnetization(const Lattice &lattice);
+}
+
+
+#endif //ISING2021_MULTISPIN_H
@@ -0,0 +1,168 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "NFold.h"
+#include <cmath>
+
+
+namespace NFold {
+
+    void init(Lattice &lattice,
+              const std::vector<int> &next,
+              const std::vector<int> &previous,
+              const std::vector<int> &up,
+              const std::vector<int> &down) {
+        lattice.size = static_cast<int>(next.size());
+        lattice.next = next;
+        lattice.previous = previous;
+        lattice.up = up;
+        lattice.down = down;
+        lattice.spins.assign(lattice.size, 1);
+        lattice.classOf.assign(lattice.size, 0);
+        lattice.positionOf.assign(lattice.size, 0);
+        for (auto &list : lattice.members)
+            list.reserve(lattice.size);
+    }
+
+    void setTemperature(Lattice &lattice, const std::array<double, 5> &boltzmannCoeffs, pcg64 &rng) {
+        /** boltzmannCoeffs[(dE + 8) / 4] = exp(-dE / T) of both models, the rates are capped at 1 as in Metropolis */
+        for (int c = 0; c < 5; ++c)
+            lattice.rates[c] = std::min(1.0, boltzmannCoeffs[c]);
+        RandomBuffer::seed(lattice.random, rng);
+    }
+
+    static int classOf(const Lattice &lattice, int i) {
+        const int h = lattice.spins[lattice.next[i]] + lattice.spins[lattice.previous[i]] +
+                      lattice.spins[lattice.up[i]] + lattice.spins[lattice.down[i]];
+        return (2 * lattice.spins[i] * h + 8) >> 2;
+    }
+
+    static void reclassify(Lattice &lattice, int i) {
+        /** Move the site to the list of its current class (swap with the last member, O(1)) */
+        const int now = classOf(lattice, i);
+        const int before = lattice.classOf[i];
+        if (now == before)
+            return;
+        auto &from = lattice.members[before];
+        const int last = from.back();
+        from[lattice.positionOf[i]] = last;
+        lattice.positionOf[last] = lattice.positionOf[i];
+        from.pop_back();
+        lattice.positionOf[i] = static_cast<int>(lattice.members[now].size());
+        lattice.members[now].push_back(i);
+        lattice.classOf[i] = static_cast<uint8_t>(now);
+    }
+
+    static void rebuild(Lattice &lattice) {
+        /** Classes, lists and totals of freshly loaded spins */
+        for (auto &list : lattice.members)
+            list.clear();
+        lattice.magnetization = 0;
+        lattice.energy = 0;
+        for (int i = 0; i < lattice.size; ++i) {
+            const int c = classOf(lattice, i);
+            lattice.classOf[i] = static_cast<uint8_t>(c);
+            lattice.positionOf[i] = static_cast<int>(lattice.members[c].size());
+            lattice.members[c].push_back(i);
+            lattice.magnetization += lattice.spins[i];
+            lattice.energy -= lattice.spins[i] * (lattice.spins[lattice.next[i]] + lattice.spins[lattice.down[i]]);
+        }
+        lattice.flips = 0;
+        lattice.steps = 0;
+    }
+
+    void load(Lattice &lattice, const std::vector<int> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            lattice.spins[i] = static_cast<int8_t>(spins[i]);
+        rebuild(lattice);
+    }
+
+    void load(Lattice &lattice, const std::vector<bool> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            lattice.spins[i] = spins[i] ? 1 : -1;
+        rebuild(lattice);
+    }
+
+    void store(const Lattice &lattice, std::vector<int> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = lattice.spins[i];
+    }
+
+    void store(const Lattice &lattice, std::vector<bool> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = lattice.spins[i] > 0;
+    }
+
+    static double uniform(Lattice &lattice) {
+        /** (0, 1), never 0 so the logarithm of the waiting time is finite */
+        return (static_cast<double>(RandomBuffer::next(lattice.random)) + 0.5) * 0x1p-32;
+    }
+
+    static void flip(Lattice &lattice, int i) {
+        const int s = lattice.spins[i];
+        const int h = lattice.spins[lattice.next[i]] + lattice.spins[lattice.previous[i]] +
+                      lattice.spins[lattice.up[i]] + lattice.spins[lattice.down[i]];
+        lattice.spins[i] = static_cast<int8_t>(-s);
+        lattice.magnetization -= 2 * s;
+        lattice.energy += 2 * s * h;
+        reclassify(lattice, i);
+        reclassify(lattice, lattice.next[i]);
+        reclassify(lattice, lattice.previous[i]);
+        reclassify(lattice, lattice.up[i]);
+        reclassify(lattice, lattice.down[i]);
+        ++lattice.flips;
+    }
+
+    void advance(Lattice &lattice, double sweeps) {
+        /**
+         * The waiting time of a state is exponential with the rate sum_c rates[c] |members[c]| / N per attempt,
+         * i.e. per sweep sum_c rates[c] |members[c]|. A waiting time that overshoots the interval is dropped:
+         * by memorylessness the state at the end of the interval is the correct one.
+         */
+        double remaining = sweeps;
+        while (true) {
+            std::array<double, 5> classRates{};
+            double total = 0.0;
+            for (int c = 0; c < 5; ++c) {
+                classRates[c] = lattice.rates[c] * static_cast<double>(lattice.members[c].size());
+                total += classRates[c];
+            }
+            if (total <= 0.0)
+                return;
+            remaining += std::log(uniform(lattice)) / total;
+            if (remaining < 0.0)
+                return;
+
+            double pick = uniform(lattice) * total;
+            int c = 0;
+            while (c < 4 && (pick -= classRates[c]) >= 0.0)
+                ++c;
+            // rounding can select an empty class at the end
+            while (lattice.members[c].empty())
+                --c;
+            const auto &list = lattice.members[c];
+            flip(lattice, list[RandomBuffer::bounded(lattice.random, static_cast<uint32_t>(list.size()))]);
+        }
+    }
+
+    void monteCarloStep(Lattice &lattice) {
+        advance(lattice, 1.0);
+        ++lattice.steps;
+    }
+
+    void thermalize(Lattice &lattice, int warmingTime) {
+        /** warmingTime is given in single-spin updates, as for the random sequential updating */
+        advance(lattice, static_cast<double>(warmingTime) / lattice.size);
+        lattice.flips = 0;
+        lattice.steps = 0;
+    }
+
+    double magnetization(const Lattice &lattice) {
+        return static_cast<double>(lattice.magnetization) / lattice.size;
+    }
+
+    double flipsPerStep(const Lattice &lattice) {
+        return lattice.steps ? static_cast<double>(lattice.flips) / lattice.steps : 0.0;
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_NFOLD_H
+#define ISING2021_NFOLD_H
+
+#include "Utils.h"
+#include "RandomBuffer.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace NFold {
+    /**
+     * Rejection-free n-fold way (Bortz, Kalos & Lebowitz) for the single-spin Metropolis dynamics.
+     * Every site belongs to one of 5 classes by its dE = 2 s h in {-8, -4, 0, 4, 8}; each class keeps the list
+     * of its sites, so a flip is drawn directly (class by its total rate, then a uniform member) and the time
+     * advances by an exponential waiting time of mean 1 / (total rate) sweeps. Below Tc, where almost every
+     * Metropolis attempt is rejected, one sweep costs only the few flips that actually happen.
+     */
+    struct Lattice {
+        int size{};
+        std::vector<int> next, previous, up, down;
+        std::vector<int8_t> spins;                    // {-1,1}
+        std::vector<uint8_t> classOf;                 // (dE + 8) / 4
+        std::vector<int> positionOf;                  // index of the site in members[classOf]
+        std::array<std::vector<int>, 5> members;
+        std::array<double, 5> rates{};                // min(1, exp(-dE / T)) of every class
+        RandomBuffer::Buffer random;
+        long long magnetization{0};                   // sum of the spins
+        long long energy{0};                          // -sum over the bonds of s_i * s_j
+        long long flips{0};                           // statistics since the last load
+        long long steps{0};
+    };
+
+    void init(Lattice &lattice,
+              const std::vector<int> &next,
+              const std::vector<int> &previous,
+              const std::vector<int> &up,
+              const std::vector<int> &down);
+    void setTemperature(Lattice &lattice, const std::array<double, 5> &boltzmannCoeffs, pcg64 &rng);
+
+    void load(Lattice &lattice, const std::vector<int> &spins);
+    void load(Lattice &lattice, const std::vector<bool> &spins);
+    void store(const Lattice &lattice, std::vector<int> &spins);
+    void store(const Lattice &lattice, std::vector<bool> &spins);
+
+    // Continuous-time evolution over the given number of sweeps (N single-spin attempts each)
+    void advance(Lattice &lattice, double sweeps);
+    void monteCarloStep(Lattice &lattice);
+    void thermalize(Lattice &lattice, int warmingTime);
+
+    double magnetization(const Lattice &lattice);
+    double flipsPerStep(const Lattice &lattice);
+}
+
+
+#endif //ISING2021_NFOLD_H
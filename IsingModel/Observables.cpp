@@ -0,0 +1,93 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Observables.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+
+namespace Observables {
+
+    void add(Welford &moments, double x) {
+        ++moments.count;
+        const double delta = x - moments.mean;
+        moments.mean += delta / static_cast<double>(moments.count);
+        moments.sumSquares += delta * (x - moments.mean);
+    }
+
+    double variance(const Welford &moments) {
+        /** Population variance of the samples (the estimators below are defined with it) */
+        return moments.count ? moments.sumSquares / static_cast<double>(moments.count) : 0.0;
+    }
+
+    void reset(Accumulator &accumulator) {
+        /** Clears the samples, the series recording stays switched on */
+        const int seriesSize = accumulator.seriesSize;
+        accumulator = Accumulator{};
+        accumulator.seriesSize = seriesSize;
+    }
+
+    void add(Accumulator &accumulator, double m, double e) {
+        /** m and e per site */
+        const double m2 = m * m;
+        add(accumulator.m, m);
+        add(accumulator.absM, std::abs(m));
+        add(accumulator.m2, m2);
+        add(accumulator.m4, m2 * m2);
+        add(accumulator.e, e);
+        if (accumulator.seriesSize) {
+            accumulator.series.push_back(static_cast<int32_t>(std::lround(e * accumulator.seriesSize)));
+            accumulator.series.push_back(static_cast<int32_t>(std::lround(m * accumulator.seriesSize)));
+        }
+    }
+
+    Summary summarize(const Accumulator &accumulator, double T, int size) {
+        /**
+         * Fluctuations are taken from the Welford variances of |m| and e, which do not suffer
+         * from the cancellation in <x^2> - <x>^2; the Binder cumulant uses the raw moments
+         */
+        Summary summary;
+        summary.samples = accumulator.absM.count;
+        summary.absMagnetization = accumulator.absM.mean;
+        summary.energy = accumulator.e.mean;
+        summary.susceptibility = size * variance(accumulator.absM) / T;
+        summary.specificHeat = size * variance(accumulator.e) / (T * T);
+        const double m2 = accumulator.m2.mean;
+        summary.binder = m2 > 0.0 ? 1.0 - accumulator.m4.mean / (3.0 * m2 * m2) : 0.0;
+        return summary;
+    }
+
+    template<typename Value>
+    static void writeValue(std::ostream &file, Value value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void writeSeries(const std::string &fileName,
+                     int L,
+                     int takeEvery,
+                     const std::vector<double> &temperatures,
+                     const std::vector<std::vector<int32_t>> &series) {
+        /**
+         * Native-endian layout: "ISINGTS1", int32 L, int32 takeEvery, int32 temperatures, then for every
+         * temperature float64 T, int64 samples and samples pairs of int32 (E, M), the totals in the (-1, 1) mapping.
+         * Like the data files the sidecar is appended to, every run adds its own header and blocks.
+         */
+        std::ofstream file{fileName, std::ios::binary | std::ios::app};
+        if (!file) {
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+            return;
+        }
+        file.write("ISINGTS1", 8);
+        writeValue<int32_t>(file, L);
+        writeValue<int32_t>(file, takeEvery);
+        writeValue<int32_t>(file, static_cast<int32_t>(temperatures.size()));
+        for (size_t k = 0; k < temperatures.size(); ++k) {
+            writeValue<double>(file, temperatures[k]);
+            writeValue<int64_t>(file, static_cast<int64_t>(series[k].size() / 2));
+            file.write(reinterpret_cast<const char *>(series[k].data()),
+                       static_cast<std::streamsize>(series[k].size() * sizeof(int32_t)));
+        }
+    }
+}
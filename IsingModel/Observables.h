@@ -0,0 +1,59 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_OBSERVABLES_H
+#define ISING2021_OBSERVABLES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Observables {
+    /**
+     * Streaming moments of the sampled observables (per site), collected during simulate(...)
+     * with Welford's update, so no second pass over the configurations is needed.
+     */
+    struct Welford {
+        long long count{0};
+        double mean{0.0};
+        double sumSquares{0.0};       // sum of (x - mean)^2
+    };
+
+    struct Accumulator {
+        Welford m;
+        Welford absM;
+        Welford m2;
+        Welford m4;
+        Welford e;
+        int seriesSize{0};            // > 0: every sample is also kept as the totals E, M of seriesSize spins
+        std::vector<int32_t> series;  // E, M, E, M, ... for the offline reweighting
+    };
+
+    struct Summary {
+        long long samples{0};
+        double absMagnetization{0.0};  // <|m|>
+        double energy{0.0};            // <e>
+        double susceptibility{0.0};    // N (<m^2> - <|m|>^2) / T
+        double specificHeat{0.0};      // N (<e^2> - <e>^2) / T^2
+        double binder{0.0};            // 1 - <m^4> / (3 <m^2>^2)
+    };
+
+    void add(Welford &moments, double x);
+    double variance(const Welford &moments);
+
+    void reset(Accumulator &accumulator);
+    void add(Accumulator &accumulator, double m, double e);
+    Summary summarize(const Accumulator &accumulator, double T, int size);
+
+    // Binary sidecar with the (E, M) series of every temperature, read by utils/reweighting.py
+    void writeSeries(const std::string &fileName,
+                     int L,
+                     int takeEvery,
+                     const std::vector<double> &temperatures,
+                     const std::vector<std::vector<int32_t>> &series);
+}
+
+
+#endif //ISING2021_OBSERVABLES_H
@@ -0,0 +1,127 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_PHILOX_H
+#define ISING2021_PHILOX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+namespace Philox {
+    /**
+     * Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+     * The output is a pure function of (counter, key): any thread can compute the random word of any site
+     * without shared state, so the random numbers do not depend on how the work is partitioned.
+     */
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    inline void mulhilo(uint32_t a, uint32_t b, uint32_t &hi, uint32_t &lo) {
+        const uint64_t product = static_cast<uint64_t>(a) * b;
+        hi = static_cast<uint32_t>(product >> 32);
+        lo = static_cast<uint32_t>(product);
+    }
+
+    inline Counter generate(Counter counter, Key key) {
+        /** 10 rounds of the Philox S-box with the standard multipliers and Weyl key schedule */
+        for (int round = 0; round < 10; ++round) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(0xD2511F53u, counter[0], hi0, lo0);
+            mulhilo(0xCD9E8D57u, counter[2], hi1, lo1);
+            counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        return counter;
+    }
+
+    inline Key makeKey(uint64_t seed) {
+        return {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    }
+
+#if defined(__AVX2__)
+    inline void mulhilo8(__m256i a, uint32_t multiplier, __m256i &hi, __m256i &lo) {
+        /** mulhilo of 8 lanes: _mm256_mul_epu32 multiplies the even lanes, the odd ones are shifted down first */
+        const __m256i m = _mm256_set1_epi32(static_cast<int>(multiplier));
+        const __m256i even = _mm256_mul_epu32(a, m);
+        const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+
+    inline void generate8(uint32_t *out, uint32_t firstBlock, uint32_t stream, uint32_t stepLo, uint32_t stepHi, Key key) {
+        /** Eight consecutive blocks at once (one counter per lane), out[4 * b + w] = word w of the block b */
+        __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstBlock)),
+                                      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i c1 = _mm256_set1_epi32(static_cast<int>(stream));
+        __m256i c2 = _mm256_set1_epi32(static_cast<int>(stepLo));
+        __m256i c3 = _mm256_set1_epi32(static_cast<int>(stepHi));
+        for (int round = 0; round < 10; ++round) {
+            __m256i hi0, lo0, hi1, lo1;
+            mulhilo8(c0, 0xD2511F53u, hi0, lo0);
+            mulhilo8(c2, 0xCD9E8D57u, hi1, lo1);
+            const __m256i k0 = _mm256_set1_epi32(static_cast<int>(key[0]));
+            const __m256i k1 = _mm256_set1_epi32(static_cast<int>(key[1]));
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), k0);
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), k1);
+            c3 = lo0;
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        // 4 x 8 -> 8 x 4 transpose
+        const __m256i t0 = _mm256_unpacklo_epi32(c0, c1);   // b0w0 b0w1 b1w0 b1w1 | b4.. b5..
+        const __m256i t1 = _mm256_unpackhi_epi32(c0, c1);   // b2w0 b2w1 b3w0 b3w1 | b6.. b7..
+        const __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+        const __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+        const __m256i b04 = _mm256_unpacklo_epi64(t0, t2);  // block 0 | block 4
+        const __m256i b15 = _mm256_unpackhi_epi64(t0, t2);
+        const __m256i b26 = _mm256_unpacklo_epi64(t1, t3);
+        const __m256i b37 = _mm256_unpackhi_epi64(t1, t3);
+        auto *dst = reinterpret_cast<__m256i *>(out);
+        _mm256_storeu_si256(dst + 0, _mm256_permute2x128_si256(b04, b15, 0x20));
+        _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(b26, b37, 0x20));
+        _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(b04, b15, 0x31));
+        _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(b26, b37, 0x31));
+    }
+#endif
+
+    inline void fill(uint32_t *out, size_t begin, size_t end, Key key, uint64_t step, uint32_t stream = 0) {
+        /**
+         * out[j] for begin <= j < end is the word j % 4 of generate({j / 4, stream, step_lo, step_hi}, key),
+         * i.e. every index j has its own random number for every step, whichever thread asks for it.
+         * With AVX2 the whole blocks are generated eight at a time, the results are the same.
+         */
+        const auto stepLo = static_cast<uint32_t>(step);
+        const auto stepHi = static_cast<uint32_t>(step >> 32);
+        size_t block = begin / 4;
+#if defined(__AVX2__)
+        // leading block that starts before begin
+        for (size_t first = (begin + 3) / 4; block < first; ++block) {
+            const Counter words = generate({static_cast<uint32_t>(block), stream, stepLo, stepHi}, key);
+            for (size_t w = 0; w < 4; ++w)
+                if (block * 4 + w >= begin && block * 4 + w < end)
+                    out[block * 4 + w] = words[w];
+        }
+        for (; (block + 8) * 4 <= end; block += 8)
+            generate8(out + block * 4, static_cast<uint32_t>(block), stream, stepLo, stepHi, key);
+#endif
+        for (; block * 4 < end; ++block) {
+            const Counter words = generate({static_cast<uint32_t>(block), stream, stepLo, stepHi}, key);
+            for (size_t w = 0; w < 4; ++w) {
+                const size_t j = block * 4 + w;
+                if (j >= begin && j < end)
+                    out[j] = words[w];
+            }
+        }
+    }
+}
+
+
+#endif //ISING2021_PHILOX_H
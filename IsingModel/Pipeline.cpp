@@ -0,0 +1,256 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Pipeline.h"
+#include "Models.h"
+#include "Binary.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+
+
+namespace Pipeline {
+
+    Stage::Stage(size_t tasks, int sinks, size_t capacity, std::string separator, std::ostream &out)
+            : m_ring(capacity), m_out(out), m_separator(std::move(separator)), m_window(m_ring.capacity()),
+              m_rows(tasks, -1)
+    {
+        for (int s = 0; s < std::max(1, sinks); ++s)
+            m_sinks.emplace_back(&Stage::drain, this);
+    }
+
+    Stage::~Stage()
+    {
+        close();
+    }
+
+    void Stage::close()
+    {
+        m_stop.store(true, std::memory_order_release);
+        for (auto &sink : m_sinks)
+            sink.join();
+        m_sinks.clear();
+    }
+
+    Producer Stage::producer(size_t task)
+    {
+        return {this, task, 0};
+    }
+
+    void Stage::admit(const Producer &producer)
+    {
+        /** A row of a task that is not being written needs room in the reorder window */
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (producer.task != m_current && m_pending >= m_window) {
+            const auto start = std::chrono::steady_clock::now();
+            m_written.wait(lock, [&] { return producer.task == m_current || m_pending < m_window; });
+            m_windowWaits.fetch_add(1, std::memory_order_relaxed);
+            m_stalledNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        }
+        ++m_pending;
+    }
+
+    template<typename Spins>
+    static void pushRecord(Ring<Record> &ring, Producer &producer, const Spins &spins, double T, bool standardIsing,
+                           std::atomic<unsigned long long> &fullRetries, std::atomic<long long> &stalledNanoseconds,
+                           std::atomic<size_t> &peakOccupancy)
+    {
+        /** Blocks (yielding) while the ring is full, which is the back-pressure on the simulation */
+        auto fill = [&](Record &record) {
+            record.task = producer.task;
+            record.sequence = producer.sequence;
+            record.T = T;
+            record.standardIsing = standardIsing;
+            record.packed = producer.packed;
+            record.spins.resize(spins.size());
+            for (size_t i = 0; i < spins.size(); ++i)
+                record.spins[i] = static_cast<int8_t>(spins[i]);
+        };
+        if (!ring.tryPush(fill)) {
+            const auto start = std::chrono::steady_clock::now();
+            unsigned long long retries = 0;
+            do {
+                ++retries;
+                std::this_thread::yield();
+            } while (!ring.tryPush(fill));
+            fullRetries.fetch_add(retries, std::memory_order_relaxed);
+            stalledNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        }
+        ++producer.sequence;
+        const size_t occupancy = ring.occupancy();
+        size_t peak = peakOccupancy.load(std::memory_order_relaxed);
+        while (occupancy > peak && !peakOccupancy.compare_exchange_weak(peak, occupancy, std::memory_order_relaxed));
+    }
+
+    void Stage::push(Producer &producer, const std::vector<int> &spins, double T)
+    {
+        admit(producer);
+        pushRecord(m_ring, producer, spins, T, true, m_fullRetries, m_stalledNanoseconds, m_peakOccupancy);
+    }
+
+    void Stage::push(Producer &producer, const std::vector<bool> &spins, double T)
+    {
+        admit(producer);
+        pushRecord(m_ring, producer, spins, T, false, m_fullRetries, m_stalledNanoseconds, m_peakOccupancy);
+    }
+
+    static void format(const Record &record, const std::string &separator, std::string &row)
+    {
+        /** The bytes of the inline writers (writeConfigurations, Binary::writeRecord) appended to row */
+        if (record.packed) {
+            Binary::appendRecord(row, static_cast<uint32_t>(record.task), record.spins);
+            return;
+        }
+        char temperature[32];
+        // an ostream with the default flags and precision writes a double like %g
+        const int length = std::snprintf(temperature, sizeof(temperature), "%g", record.T);
+        row.append(temperature, static_cast<size_t>(length));
+        row += separator;
+        for (const int8_t spin : record.spins) {
+            if (spin < 0)
+                row += '-';
+            row += spin != 0 ? '1' : '0';
+            row += separator;
+        }
+        row += '\n';
+    }
+
+    void Stage::advance()
+    {
+        /** Writes the held rows that are next in turn and moves on to the next task when one is complete */
+        while (m_current < m_rows.size()) {
+            const auto held = m_held.find({m_current, m_next});
+            if (held != m_held.end()) {
+                m_out << held->second;
+                m_spare.push_back(std::move(held->second));
+                m_held.erase(held);
+                ++m_next;
+                --m_pending;
+            } else if (m_rows[m_current] >= 0 && m_next == static_cast<size_t>(m_rows[m_current])) {
+                ++m_current;
+                m_next = 0;
+            } else {
+                break;
+            }
+        }
+    }
+
+    void Stage::deliver(const Record &record, std::string &row)
+    {
+        /** The row in turn goes to out, any other one is held; row keeps a buffer for the next record */
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (record.task == m_current && record.sequence == m_next) {
+                m_out << row;
+                ++m_next;
+                --m_pending;
+                advance();
+            } else {
+                std::string held;
+                if (!m_spare.empty()) {
+                    held = std::move(m_spare.back());
+                    m_spare.pop_back();
+                }
+                held.swap(row);
+                m_held.emplace(std::make_pair(record.task, record.sequence), std::move(held));
+                if (m_held.size() > m_peakHeld.load(std::memory_order_relaxed))
+                    m_peakHeld.store(m_held.size(), std::memory_order_relaxed);
+            }
+        }
+        m_written.notify_all();
+    }
+
+    void Stage::finish(const Producer &producer)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rows[producer.task] = static_cast<long long>(producer.sequence);
+            advance();
+        }
+        m_written.notify_all();
+    }
+
+    void Stage::drain()
+    {
+        Record record;
+        std::string row;
+        std::chrono::microseconds pause{0};
+        while (true) {
+            const bool popped = m_ring.tryPop([&](Record &slot) {
+                record.task = slot.task;
+                record.sequence = slot.sequence;
+                record.T = slot.T;
+                record.standardIsing = slot.standardIsing;
+                record.packed = slot.packed;
+                record.spins.swap(slot.spins);        // the slot keeps the previous buffer for the next push
+            });
+            if (!popped) {
+                if (m_stop.load(std::memory_order_acquire) && m_ring.occupancy() == 0)
+                    return;
+                m_emptyPolls.fetch_add(1, std::memory_order_relaxed);
+                // exponential back-off up to 1 ms, idle sinks must not take the cores away from the simulation
+                if (pause.count() == 0) {
+                    std::this_thread::yield();
+                    pause = std::chrono::microseconds(10);
+                } else {
+                    std::this_thread::sleep_for(pause);
+                    pause = std::min(2 * pause, std::chrono::microseconds(1000));
+                }
+                continue;
+            }
+            pause = std::chrono::microseconds(0);
+            row.clear();
+            format(record, m_separator, row);
+            deliver(record, row);
+            m_records.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Metrics Stage::metrics() const
+    {
+        Metrics metrics;
+        metrics.records = m_records.load();
+        metrics.fullRetries = m_fullRetries.load();
+        metrics.stalledSeconds = static_cast<double>(m_stalledNanoseconds.load()) * 1e-9;
+        metrics.windowWaits = m_windowWaits.load();
+        metrics.emptyPolls = m_emptyPolls.load();
+        metrics.peakOccupancy = m_peakOccupancy.load();
+        metrics.peakHeld = m_peakHeld.load();
+        metrics.capacity = m_ring.capacity();
+        return metrics;
+    }
+
+    void write(Producer &producer, const std::vector<int> &spins, double T, std::ostream &file, const std::string &separator)
+    {
+        if (producer.stage)
+            producer.stage->push(producer, spins, T);
+        else if (producer.packed)
+            Binary::writeRecord(file, static_cast<uint32_t>(producer.task), spins);
+        else
+            writeConfigurations(spins, T, file, separator);
+    }
+
+    void write(Producer &producer, const std::vector<bool> &spins, double T, std::ostream &file, const std::string &separator)
+    {
+        if (producer.stage)
+            producer.stage->push(producer, spins, T);
+        else if (producer.packed)
+            Binary::writeRecord(file, static_cast<uint32_t>(producer.task), spins);
+        else
+            BoolSpinConfigurations::writeConfigurations(spins, T, file, separator);
+    }
+
+    std::string summary(const Metrics &metrics)
+    {
+        std::ostringstream text;
+        text << "pipeline: records=" << metrics.records << " peak=" << metrics.peakOccupancy << "/" << metrics.capacity
+             << " held=" << metrics.peakHeld << " full retries=" << metrics.fullRetries
+             << " window waits=" << metrics.windowWaits << " stalled=" << metrics.stalledSeconds << " s"
+             << " empty polls=" << metrics.emptyPolls;
+        return text.str();
+    }
+}
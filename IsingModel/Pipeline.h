@@ -0,0 +1,209 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISINGMODEL_PIPELINE_H
+#define ISINGMODEL_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace Pipeline {
+
+template<typename Value>
+class Ring {
+    /**
+     * Bounded lock-free multi-producer multi-consumer queue (D. Vyukov). Every cell has a sequence number:
+     * pos means free for the producer of ticket pos, pos + 1 means filled for the consumer of ticket pos.
+     * The values live in the cells and are filled / drained in place, so the slots (and the capacity of their
+     * vectors) are allocated once and reused.
+     */
+        private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            Value value;
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_enqueue{0};
+        alignas(64) std::atomic<size_t> m_dequeue{0};
+
+        public:
+        explicit Ring(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+            m_cells = std::make_unique<Cell[]>(size);
+            m_mask = size - 1;
+            for (size_t i = 0; i < size; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        Ring(const Ring &) = delete;
+        Ring &operator=(const Ring &) = delete;
+
+        [[nodiscard]] size_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        [[nodiscard]] size_t occupancy() const
+        {
+            /** Approximate number of filled cells (exact when no push or pop is in flight) */
+            const size_t enqueued = m_enqueue.load(std::memory_order_relaxed);
+            const size_t dequeued = m_dequeue.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        template<typename Fill>
+        bool tryPush(Fill &&fill)
+        {
+            /** fill(value) writes the claimed cell; false if the ring is full */
+            size_t position = m_enqueue.load(std::memory_order_relaxed);
+            while (true) {
+                Cell &cell = m_cells[position & m_mask];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+                if (difference == 0) {
+                    if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        fill(cell.value);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        template<typename Drain>
+        bool tryPop(Drain &&drain)
+        {
+            /** drain(value) consumes the claimed cell; false if the ring is empty */
+            size_t position = m_dequeue.load(std::memory_order_relaxed);
+            while (true) {
+                Cell &cell = m_cells[position & m_mask];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+                if (difference == 0) {
+                    if (m_dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        drain(cell.value);
+                        cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_dequeue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+};
+
+struct Record {
+    size_t task{0};
+    size_t sequence{0};                               // row of the task
+    double T{0.0};
+    bool standardIsing{true};                         // spins -1/1, otherwise 0/1
+    bool packed{false};                               // Binary record instead of a text row
+    std::vector<int8_t> spins;
+};
+
+struct Metrics {
+    unsigned long long records{0};
+    unsigned long long fullRetries{0};                // pushes that found the ring full (back-pressure)
+    double stalledSeconds{0.0};                       // time the producers waited for a free slot or the window
+    unsigned long long windowWaits{0};                // pushes that waited for the reorder window
+    unsigned long long emptyPolls{0};                 // polls of the sinks that found the ring empty
+    size_t peakOccupancy{0};
+    size_t peakHeld{0};                               // most rows held back for their turn
+    size_t capacity{0};
+};
+
+class Stage;
+
+struct Producer {
+    /** Output of one simulation task: stage == nullptr writes inline to the task's stream */
+    Stage *stage{nullptr};
+    size_t task{0};
+    size_t sequence{0};
+    bool packed{false};                               // format=bin: Binary records indexed by task
+};
+
+class Stage {
+    /**
+     * Moves the formatting and the writing of the saved configurations off the Monte Carlo threads: simulate
+     * copies the spins into a preallocated ring slot, the sink threads format them into their own reused buffer
+     * and write the rows straight to out in the original order (task by task, then row by row), so the data file
+     * is byte-identical to the inline writing. Rows that arrive before their turn are held back, at most
+     * window of them: while the window is full only the task being written can push.
+     */
+        private:
+        Ring<Record> m_ring;
+        std::ostream &m_out;
+        std::string m_separator;
+        size_t m_window;
+        std::vector<std::thread> m_sinks;
+        std::mutex m_mutex;                           // the reorder state below and the writes to m_out
+        std::condition_variable m_written;            // producers waiting for room in the window
+        std::vector<long long> m_rows;                // rows of every task, -1 until the task is finished
+        std::map<std::pair<size_t, size_t>, std::string> m_held;   // (task, row) formatted before its turn
+        std::vector<std::string> m_spare;             // buffers of the written held rows, reused
+        size_t m_current{0};                          // task being written
+        size_t m_next{0};                             // its next row
+        size_t m_pending{0};                          // rows pushed and not written yet
+        std::atomic<bool> m_stop{false};
+        std::atomic<unsigned long long> m_records{0};
+        std::atomic<unsigned long long> m_fullRetries{0};
+        std::atomic<long long> m_stalledNanoseconds{0};
+        std::atomic<unsigned long long> m_windowWaits{0};
+        std::atomic<unsigned long long> m_emptyPolls{0};
+        std::atomic<size_t> m_peakOccupancy{0};
+        std::atomic<size_t> m_peakHeld{0};
+
+        void drain();
+        void admit(const Producer &producer);
+        void deliver(const Record &record, std::string &row);
+        void advance();
+
+        public:
+        Stage(size_t tasks, int sinks, size_t capacity, std::string separator, std::ostream &out);
+        ~Stage();
+
+        Stage(const Stage &) = delete;
+        Stage &operator=(const Stage &) = delete;
+
+        Producer producer(size_t task);
+        void push(Producer &producer, const std::vector<int> &spins, double T);
+        void push(Producer &producer, const std::vector<bool> &spins, double T);
+        // The producer pushed its last row, the next task is written once these rows are out (does not wait)
+        void finish(const Producer &producer);
+        // Writes the remaining rows and stops the sinks, every task must be finished
+        void close();
+        [[nodiscard]] Metrics metrics() const;
+};
+
+// A saved configuration of simulate(...): to the stage of the producer if it has one, otherwise formatted inline
+void write(Producer &producer, const std::vector<int> &spins, double T, std::ostream &file, const std::string &separator);
+void write(Producer &producer, const std::vector<bool> &spins, double T, std::ostream &file, const std::string &separator);
+
+std::string summary(const Metrics &metrics);
+
+}
+
+
+#endif //ISINGMODEL_PIPELINE_H
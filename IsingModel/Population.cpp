@@ -0,0 +1,208 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Population.h"
+#include "Seeding.h"
+#include "ThreadTeam.h"
+#include <algorithm>
+#include <memory>
+
+
+namespace Population {
+
+    static void writeConfiguration(const std::vector<int> &spins, double T, bool standardIsing,
+                                   std::ostream &file, const std::string &separator) {
+        if (standardIsing) {
+            writeConfigurations(spins, T, file, separator);
+            return;
+        }
+        std::vector<bool> bits(spins.size());
+        for (size_t i = 0; i < spins.size(); ++i)
+            bits[i] = spins[i] > 0;
+        BoolSpinConfigurations::writeConfigurations(bits, T, file, separator);
+    }
+
+    static double overlap(const std::vector<long long> &energies, double deltaBeta) {
+        /** (sum w)^2 / (R sum w^2) of the weights exp(-deltaBeta E_i), 1 for equal weights */
+        const long long lowest = *std::min_element(energies.begin(), energies.end());
+        double sum = 0.0, sumSquares = 0.0;
+        for (const long long energy : energies) {
+            const double weight = std::exp(-deltaBeta * static_cast<double>(energy - lowest));
+            sum += weight;
+            sumSquares += weight * weight;
+        }
+        return sum * sum / (sumSquares * static_cast<double>(energies.size()));
+    }
+
+    static double nextBeta(const std::vector<long long> &energies, double beta, double target, double fraction) {
+        /**
+         * Largest step towards target that keeps the effective population above fraction * R (bisection),
+         * so a coarse grid (or the first step from infinite temperature) is split into intermediate temperatures
+         */
+        if (overlap(energies, target - beta) >= fraction)
+            return target;
+        double low = 0.0, high = target - beta;
+        for (int iteration = 0; iteration < 40; ++iteration) {
+            const double middle = 0.5 * (low + high);
+            (overlap(energies, middle) >= fraction ? low : high) = middle;
+        }
+        return beta + std::max(low, 1e-6 * (target - beta));
+    }
+
+    static double resample(std::vector<std::vector<int>> &population, std::vector<std::vector<int>> &buffer,
+                           std::vector<long long> &energies, std::vector<int> &families,
+                           double deltaBeta, pcg64 &rng) {
+        /**
+         * Systematic resampling with the weights exp(-deltaBeta E_i): replica i gets floor(R w_i / W + u) copies
+         * (one uniform u for the whole population). Returns ln of the mean weight, the free-energy increment.
+         */
+        const auto count = static_cast<int>(population.size());
+        const long long lowest = *std::min_element(energies.begin(), energies.end());
+        std::vector<double> weights(count);
+        double total = 0.0;
+        for (int i = 0; i < count; ++i) {
+            weights[i] = std::exp(-deltaBeta * static_cast<double>(energies[i] - lowest));
+            total += weights[i];
+        }
+
+        std::uniform_real_distribution<double> realDist{0.0, 1.0};
+        const double offset = realDist(rng);
+        std::vector<long long> newEnergies(count);
+        std::vector<int> newFamilies(count);
+        double cumulative = 0.0;
+        int filled = 0;
+        for (int i = 0; i < count && filled < count; ++i) {
+            cumulative += weights[i] * count / total;
+            for (; filled < count && filled + offset < cumulative; ++filled) {
+                buffer[filled] = population[i];
+                newEnergies[filled] = energies[i];
+                newFamilies[filled] = families[i];
+            }
+        }
+        // rounding of the cumulative sum can leave the last slots empty
+        for (; filled < count; ++filled) {
+            buffer[filled] = population[count - 1];
+            newEnergies[filled] = energies[count - 1];
+            newFamilies[filled] = families[count - 1];
+        }
+        population.swap(buffer);
+        energies.swap(newEnergies);
+        families.swap(newFamilies);
+        return std::log(total / count) - deltaBeta * static_cast<double>(lowest);
+    }
+
+    void simulate(const std::vector<double> &temperatures,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  Boundary boundary,
+                  uint64_t seed,
+                  int replicas,
+                  int sweeps,
+                  int threads,
+                  bool standardIsing,
+                  bool saveData,
+                  std::ostream &file,
+                  const std::string &separator,
+                  std::vector<Step> &steps) {
+        /**
+         * The random numbers belong to the slots of the population (slot r uses Seeding::stream(seed, L, r)),
+         * the resampling uses the stream number replicas, so the run does not depend on the number of threads.
+         * One engine per thread is prepared for every replica it sweeps.
+         */
+        const int size = L * L;
+        std::vector<std::vector<int>> population(replicas, std::vector<int>(size));
+        std::vector<std::vector<int>> buffer(replicas);
+        std::vector<long long> energies(replicas);
+        std::vector<int> families(replicas);
+        std::vector<pcg64> streams(replicas);
+        std::uniform_int_distribution<int> choice{0, 1};
+        for (int r = 0; r < replicas; ++r) {
+            streams[r] = Seeding::stream(seed, L, r);
+            MetropolisRSU::initState(population[r], streams[r], choice);
+            energies[r] = countTotals(population[r], next, down).energy;
+            families[r] = r;
+        }
+        pcg64 rng = Seeding::stream(seed, L, replicas);
+
+        const int members = std::clamp(threads, 1, replicas);
+        std::unique_ptr<ThreadTeam> team;
+        if (members > 1)
+            team = std::make_unique<ThreadTeam>(members);
+        std::vector<SweepEngine> engines(members);
+        for (SweepEngine &engine : engines) {
+            engine.boundary = boundary;
+            if (boundary == Boundary::Helical)
+                Helical::init(engine.helical, L);
+        }
+        std::vector<RunningTotals> totals(replicas);
+        std::array<double, 5> coefficients{};
+        const std::function<void(int)> sweep = [&](int member) {
+            SweepEngine &engine = engines[member];
+            std::uniform_real_distribution<double> realDist{0.0, 1.0};
+            std::uniform_int_distribution<int> intDist{0, size - 1};
+            for (int r = member; r < replicas; r += members) {
+                MetropolisRSU::prepare(engine, population[r], next, down, coefficients, streams[r]);
+                for (int s = 0; s < sweeps; ++s)
+                    MetropolisRSU::monteCarloStep(engine, size, population[r], next, previous, up, down,
+                                                  streams[r], realDist, intDist);
+                MetropolisRSU::synchronize(engine, population[r]);
+                totals[r] = engine.totals;
+            }
+        };
+
+        steps.assign(temperatures.size(), Step{});
+        double beta = 0.0;
+        double logPartition = size * std::log(2.0);    // ln Z at infinite temperature
+        for (size_t k = 0; k < temperatures.size(); ++k) {
+            const double T = temperatures[k];
+            int intermediate = -1;
+            while (beta < 1.0 / T) {
+                const double target = nextBeta(energies, beta, 1.0 / T, 0.5);
+                logPartition += resample(population, buffer, energies, families, target - beta, rng);
+                beta = target;
+                coefficients = MetropolisRSU::calculateBoltzmannCoeff(1.0 / beta);
+                if (team)
+                    team->run(sweep);
+                else
+                    sweep(0);
+                for (int r = 0; r < replicas; ++r)
+                    energies[r] = totals[r].energy;
+                ++intermediate;
+            }
+
+            Observables::Accumulator observables;
+            for (int r = 0; r < replicas; ++r) {
+                Observables::add(observables, static_cast<double>(totals[r].magnetization) / size,
+                                 static_cast<double>(totals[r].energy) / size);
+            }
+            Step &step = steps[k];
+            step.summary = Observables::summarize(observables, T, size);
+            step.freeEnergy = -T * logPartition / size;
+            step.intermediate = std::max(0, intermediate);
+            std::vector<int> distinct = families;
+            std::sort(distinct.begin(), distinct.end());
+            step.families = static_cast<int>(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+
+            if (saveData) {
+                // every replica is a sample of the temperature, each row carries the averages over all of them
+                std::vector<bool> bits(size);
+                for (const auto &spins : population) {
+                    if (standardIsing) {
+                        writeData(spins, step.summary, T, file, separator);
+                        continue;
+                    }
+                    for (int i = 0; i < size; ++i)
+                        bits[i] = spins[i] > 0;
+                    BoolSpinConfigurations::writeData(bits, step.summary, T, file, separator);
+                }
+                continue;
+            }
+            for (const auto &spins : population)
+                writeConfiguration(spins, T, standardIsing, file, separator);
+        }
+    }
+}
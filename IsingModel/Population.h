@@ -0,0 +1,50 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_POPULATION_H
+#define ISING2021_POPULATION_H
+
+#include "Models.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Population {
+    /**
+     * Population annealing (Hukushima & Iba; Machta): R replicas start in the exact infinite-temperature state
+     * and are annealed down the temperature grid. Every step reweights them with exp(-(b_k - b_k-1) E),
+     * resamples the population (systematic resampling, R stays fixed) and runs a few single-spin sweeps
+     * of every replica in parallel, so each temperature yields R configurations at once.
+     * Steps that would leave less than half of the population effective are split automatically.
+     */
+    struct Step {
+        Observables::Summary summary;
+        double freeEnergy{0.0};       // per site, from the products of the mean weights
+        int families{0};              // distinct initial replicas that still have descendants
+        int intermediate{0};          // temperatures inserted before this one to keep the weights balanced
+    };
+
+    // Writes the R configurations of every temperature, with saveData each one with the observables averaged
+    // over the whole population
+    void simulate(const std::vector<double> &temperatures,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  Boundary boundary,
+                  uint64_t seed,
+                  int replicas,
+                  int sweeps,
+                  int threads,
+                  bool standardIsing,
+                  bool saveData,
+                  std::ostream &file,
+                  const std::string &separator,
+                  std::vector<Step> &steps);
+}
+
+
+#endif //ISING2021_POPULATION_H
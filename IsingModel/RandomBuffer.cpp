@@ -0,0 +1,33 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "RandomBuffer.h"
+
+
+namespace RandomBuffer {
+
+    void seed(Buffer &buffer, pcg64 &rng, size_t capacity) {
+        /** The key comes from the stream of the temperature, the first next() fills the block */
+        buffer.words.assign(capacity, 0);
+        buffer.position = capacity;
+        buffer.key = Philox::makeKey(rng());
+        buffer.refills = 0;
+    }
+
+    void refill(Buffer &buffer) {
+        Philox::fill(buffer.words.data(), 0, buffer.words.size(), buffer.key, buffer.refills++);
+        buffer.position = 0;
+    }
+
+    std::array<uint32_t, 5> calculateThresholds(const std::array<double, 5> &boltzmannCoeffs) {
+        /**
+         * Flip is accepted when a raw word r < threshold, i.e. with probability threshold / 2^32.
+         * Coefficients >= 1 (dE <= 0) are accepted without looking at r.
+         */
+        std::array<uint32_t, 5> thresholds{};
+        for (int i = 0; i < 5; ++i)
+            thresholds[i] = toThreshold(boltzmannCoeffs[i]);
+        return thresholds;
+    }
+}
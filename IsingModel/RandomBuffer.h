@@ -0,0 +1,68 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_RANDOMBUFFER_H
+#define ISING2021_RANDOMBUFFER_H
+
+#include "Utils.h"
+#include "Philox.h"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace RandomBuffer {
+    /**
+     * Block of raw 32-bit random words for the single-spin updates.
+     * The words are produced in bulk by Philox4x32-10 (eight counters per AVX2 instruction),
+     * so the Metropolis loop only reads the next word instead of calling a distribution.
+     */
+    struct Buffer {
+        std::vector<uint32_t> words;
+        size_t position{0};
+        Philox::Key key{};
+        uint64_t refills{0};                          // Philox step of the next refill
+    };
+
+    const size_t defaultCapacity = 4096;
+
+    void seed(Buffer &buffer, pcg64 &rng, size_t capacity = defaultCapacity);
+    void refill(Buffer &buffer);
+
+    std::array<uint32_t, 5> calculateThresholds(const std::array<double, 5> &boltzmannCoeffs);
+
+    inline uint32_t toThreshold(double p) {
+        /** Acceptance probability p as a threshold on raw words: accepted when r < threshold */
+        if (p >= 1.0)
+            return std::numeric_limits<uint32_t>::max();
+        return static_cast<uint32_t>(p * 4294967296.0);
+    }
+
+    inline uint32_t next(Buffer &buffer) {
+        if (buffer.position == buffer.words.size())
+            refill(buffer);
+        return buffer.words[buffer.position++];
+    }
+
+    inline uint32_t bounded(Buffer &buffer, uint32_t range) {
+        /**
+         * Uniform integer in [0, range) (Lemire, "Fast random integer generation in an interval"):
+         * the high half of next * range, with rejection of the few low halves that would bias it
+         */
+        uint64_t product = static_cast<uint64_t>(next(buffer)) * range;
+        auto low = static_cast<uint32_t>(product);
+        if (low < range) {
+            const uint32_t limit = static_cast<uint32_t>(-range) % range;
+            while (low < limit) {
+                product = static_cast<uint64_t>(next(buffer)) * range;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+}
+
+
+#endif //ISING2021_RANDOMBUFFER_H
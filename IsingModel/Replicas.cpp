@@ -0,0 +1,167 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Replicas.h"
+#include "Models.h"
+#include "RandomBuffer.h"
+#include <algorithm>
+#include <bit>
+
+
+namespace Replicas {
+/** ************************************************************************
+ *
+ * Replica-parallel multi-spin coding: one bitwise Metropolis update of a site
+ * updates the same site in all (up to 64) independent chains
+ *
+ * *************************************************************************
+ * */
+
+    void init(Lattice &lattice, int size, int count) {
+        lattice.size = size;
+        lattice.count = count;
+        lattice.active = count >= maxReplicas ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+        lattice.sites.assign(size, 0);
+    }
+
+    void initState(Lattice &lattice, pcg64 &rng) {
+        /** Every replica starts from its own random configuration */
+        for (auto &site : lattice.sites)
+            site = static_cast<uint64_t>(rng()) & lattice.active;
+    }
+
+    void setTemperatures(Lattice &lattice, const std::vector<double> &temperatures) {
+        lattice.planes4.fill(0);
+        lattice.planes8.fill(0);
+        for (int k = 0; k < lattice.count; ++k) {
+            const auto boltzmannCoeffs = BoolSpinConfigurations::calculateBoltzmannCoeff(temperatures[k]);
+            const uint32_t threshold4 = RandomBuffer::toThreshold(boltzmannCoeffs[3]);
+            const uint32_t threshold8 = RandomBuffer::toThreshold(boltzmannCoeffs[4]);
+            for (int b = 0; b < 32; ++b) {
+                lattice.planes4[b] |= static_cast<uint64_t>((threshold4 >> b) & 1) << k;
+                lattice.planes8[b] |= static_cast<uint64_t>((threshold8 >> b) & 1) << k;
+            }
+        }
+    }
+
+    void monteCarloStep(Lattice &lattice,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng) {
+        /**
+         * Sequential sweep over all sites (as in BoolSpinConfigurations, algorithm ver 1).
+         * x_i = s ^ neighbour_i marks anti-aligned neighbours of the site in every replica:
+         * two or more -> dE <= 0, one -> dE = 4, none -> dE = 8.
+         * The uniform number of every replica is compared with its threshold bit-plane by bit-plane.
+         */
+        uint64_t *sites = lattice.sites.data();
+        for (int i = 0; i < lattice.size; ++i) {
+            const uint64_t s = sites[i];
+            const uint64_t x1 = s ^ sites[previous[i]];
+            const uint64_t x2 = s ^ sites[next[i]];
+            const uint64_t x3 = s ^ sites[up[i]];
+            const uint64_t x4 = s ^ sites[down[i]];
+
+            const uint64_t atLeastTwo = (x1 & x2) | (x3 & x4) | ((x1 ^ x2) & (x3 ^ x4));
+            const uint64_t none = ~(x1 | x2 | x3 | x4);
+            const uint64_t one = ~(atLeastTwo | none);
+
+            uint64_t need4 = one & lattice.active;
+            uint64_t need8 = none & lattice.active;
+            uint64_t less4 = 0, less8 = 0;
+            for (int b = 31; b >= 0 && (need4 | need8); --b) {
+                const uint64_t u = rng();
+                const uint64_t decided4 = need4 & (u ^ lattice.planes4[b]);
+                const uint64_t decided8 = need8 & (u ^ lattice.planes8[b]);
+                less4 |= decided4 & lattice.planes4[b];
+                less8 |= decided8 & lattice.planes8[b];
+                need4 &= ~decided4;
+                need8 &= ~decided8;
+            }
+            sites[i] = s ^ (lattice.active & (atLeastTwo | (one & less4) | (none & less8)));
+        }
+    }
+
+    void thermalize(Lattice &lattice,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng) {
+        /** warmingTime is given in single-spin updates of one lattice */
+        const int sweeps = (warmingTime + lattice.size - 1) / lattice.size;
+        for (int k = 0; k < sweeps; ++k)
+            monteCarloStep(lattice, next, previous, up, down, rng);
+    }
+
+    void extract(const Lattice &lattice, int replica, std::vector<bool> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = (lattice.sites[i] >> replica) & 1;
+    }
+
+    void extract(const Lattice &lattice, int replica, std::vector<int> &spins) {
+        for (int i = 0; i < lattice.size; ++i)
+            spins[i] = ((lattice.sites[i] >> replica) & 1) ? 1 : -1;
+    }
+
+    double magnetization(const Lattice &lattice, int replica) {
+        long long m = 0;
+        for (const auto &site : lattice.sites)
+            m += (site >> replica) & 1;
+        return (2.0 * m - lattice.size) / lattice.size;
+    }
+
+    void simulate(Lattice &lattice,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  pcg64 &rng,
+                  const std::vector<double> &temperatures,
+                  const std::vector<int> &rows,
+                  int warmingTime,
+                  int takeEvery,
+                  bool standardIsing,
+                  std::ostream &file,
+                  const std::string &separator) {
+        /**
+         * Writes the configurations of every replica in the row format of writeConfigurations.
+         * The lattice words of every sampling step are kept (one bit-plane per replica) until the last chain has
+         * its rows, then the rows are written replica by replica.
+         */
+        const int size = static_cast<int>(next.size());
+        init(lattice, size, static_cast<int>(temperatures.size()));
+        setTemperatures(lattice, temperatures);
+        initState(lattice, rng);
+
+        thermalize(lattice, next, previous, up, down, warmingTime, rng);
+
+        const int samples = rows.empty() ? 0 : *std::max_element(rows.begin(), rows.end());
+        std::vector<uint64_t> kept;
+        kept.reserve(static_cast<size_t>(samples) * size);
+        for (int i = 0; static_cast<int>(kept.size() / size) < samples; ++i) {
+            monteCarloStep(lattice, next, previous, up, down, rng);
+            if (i % takeEvery == 0)
+                kept.insert(kept.end(), lattice.sites.begin(), lattice.sites.end());
+        }
+
+        std::vector<bool> boolSpins(size);
+        std::vector<int> spins(size);
+        for (int k = 0; k < lattice.count; ++k)
+            for (int n = 0; n < rows[k]; ++n) {
+                const uint64_t *sites = kept.data() + static_cast<size_t>(n) * size;
+                for (int i = 0; i < size; ++i) {
+                    boolSpins[i] = (sites[i] >> k) & 1;
+                    spins[i] = boolSpins[i] ? 1 : -1;
+                }
+                if (standardIsing)
+                    writeConfigurations(spins, temperatures[k], file, separator);
+                else
+                    BoolSpinConfigurations::writeConfigurations(boolSpins, temperatures[k], file, separator);
+            }
+    }
+}
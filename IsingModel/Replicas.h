@@ -0,0 +1,72 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_REPLICAS_H
+#define ISING2021_REPLICAS_H
+
+#include "Utils.h"
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+
+namespace Replicas {
+    constexpr int maxReplicas = 64;
+
+    /**
+     * Up to 64 independent lattices stored bit-wise: bit k of sites[i] is the spin i of the replica k.
+     * Every replica has its own temperature, kept as bit-planes of the integer acceptance thresholds.
+     */
+    struct Lattice {
+        int size{};
+        int count{};                                  // replicas in use
+        uint64_t active{};                            // mask of the replicas in use
+        std::vector<uint64_t> sites;
+        std::array<uint64_t, 32> planes4{};           // bit b of the dE = 4 threshold of every replica
+        std::array<uint64_t, 32> planes8{};           // bit b of the dE = 8 threshold of every replica
+    };
+
+    void init(Lattice &lattice, int size, int count);
+    void initState(Lattice &lattice, pcg64 &rng);
+    void setTemperatures(Lattice &lattice, const std::vector<double> &temperatures);
+
+    void monteCarloStep(Lattice &lattice,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down,
+                        pcg64 &rng);
+
+    void thermalize(Lattice &lattice,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng);
+
+    void extract(const Lattice &lattice, int replica, std::vector<bool> &spins);
+    void extract(const Lattice &lattice, int replica, std::vector<int> &spins);
+    double magnetization(const Lattice &lattice, int replica);
+
+    // Runs temperatures.size() (<= 64) chains, chain k contributes its first rows[k] configurations taken every
+    // takeEvery steps; the rows are written chain by chain, so neighbouring chains of one temperature form its block
+    void simulate(Lattice &lattice,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  pcg64 &rng,
+                  const std::vector<double> &temperatures,
+                  const std::vector<int> &rows,
+                  int warmingTime,
+                  int takeEvery,
+                  bool standardIsing,
+                  std::ostream &file,
+                  const std::string &separator);
+}
+
+
+#endif //ISING2021_REPLICAS_H
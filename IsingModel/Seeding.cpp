@@ -0,0 +1,50 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Seeding.h"
+#include <cctype>
+#include <stdexcept>
+
+
+namespace Seeding {
+
+    uint64_t randomSeed() {
+        /** Seed from the hardware entropy, used when no seed is given on the command line */
+        pcg_extras::seed_seq_from<std::random_device> seed_source;
+        pcg64 rng(seed_source);
+        return rng();
+    }
+
+    bool parseSeed(const std::string &text, uint64_t &seed) {
+        /** Decimal, 0x hexadecimal or 0 octal, the whole text has to be the number; seed is left unchanged otherwise */
+        if (text.empty() || !std::isdigit(static_cast<unsigned char>(text.front())))
+            return false;
+        size_t used = 0;
+        uint64_t parsed;
+        try {
+            parsed = std::stoull(text, &used, 0);
+        } catch (const std::logic_error &) {
+            return false;
+        }
+        if (used != text.size())
+            return false;
+        seed = parsed;
+        return true;
+    }
+
+    pcg64 stream(uint64_t masterSeed, int L, size_t temperatureIndex, size_t replica) {
+        /**
+         * state:  the master seed (the same for every task)
+         * stream: (L, temperature index) -> one of the 2^127 streams of pcg64
+         * advance: replica * 2^64 steps, so the replicas of one task never overlap
+         */
+        const pcg_extras::pcg128_t state = PCG_128BIT_CONSTANT(0x9E3779B97F4A7C15ULL, masterSeed);
+        const pcg_extras::pcg128_t streamId = PCG_128BIT_CONSTANT(static_cast<uint64_t>(L),
+                                                                  static_cast<uint64_t>(temperatureIndex));
+        pcg64 rng(state, streamId);
+        if (replica)
+            rng.advance(PCG_128BIT_CONSTANT(static_cast<uint64_t>(replica), 0ULL));
+        return rng;
+    }
+}
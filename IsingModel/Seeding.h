@@ -0,0 +1,26 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_SEEDING_H
+#define ISING2021_SEEDING_H
+
+#include "Utils.h"
+#include <cstdint>
+#include <string>
+
+
+namespace Seeding {
+    /**
+     * Reproducible random streams derived from one master seed.
+     * Every (L, temperature index) pair selects its own pcg64 stream (the increment of the LCG),
+     * replicas of the same task use disjoint blocks of 2^64 numbers of that stream (advance()).
+     */
+    uint64_t randomSeed();
+    bool parseSeed(const std::string &text, uint64_t &seed);
+
+    pcg64 stream(uint64_t masterSeed, int L, size_t temperatureIndex, size_t replica = 0);
+}
+
+
+#endif //ISING2021_SEEDING_H
@@ -0,0 +1,194 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "SwendsenWang.h"
+#include <atomic>
+#include <cmath>
+
+
+namespace SwendsenWang {
+/** ************************************************************************
+ *
+ * Swendsen-Wang cluster updates on all cores:
+ * bond activation, lock-free union-find labelling and cluster flips are
+ * data-parallel passes over contiguous ranges of sites
+ *
+ * *************************************************************************
+ * */
+
+    void init(Workspace &workspace, int size, std::shared_ptr<ThreadTeam> team) {
+        const int threads = team->size();
+        workspace.size = size;
+        workspace.spins.assign(size, 1);
+        workspace.parent.assign(size, 0);
+        workspace.flip.assign(size, 0);
+        workspace.streams.assign(threads, pcg64{});
+        workspace.counts.assign(threads, 0);
+        workspace.team = std::move(team);
+    }
+
+    void setTemperature(Workspace &workspace, const std::array<double, 5> &boltzmannCoeffs, pcg64 &rng) {
+        /** boltzmannCoeffs[3] = exp(-4/T), the bond probability 1 - exp(-2/T) = 1 - sqrt(boltzmannCoeffs[3]) */
+        workspace.bondProbability = 1.0 - std::sqrt(boltzmannCoeffs[3]);
+        for (size_t t = 0; t < workspace.streams.size(); ++t)
+            workspace.streams[t] = pcg64(rng(), t);
+        workspace.clusters = 0;
+        workspace.steps = 0;
+    }
+
+    void load(Workspace &workspace, const std::vector<int> &spins) {
+        for (int i = 0; i < workspace.size; ++i)
+            workspace.spins[i] = static_cast<int8_t>(spins[i]);
+    }
+
+    void load(Workspace &workspace, const std::vector<bool> &spins) {
+        for (int i = 0; i < workspace.size; ++i)
+            workspace.spins[i] = spins[i] ? 1 : -1;
+    }
+
+    void store(const Workspace &workspace, std::vector<int> &spins) {
+        for (int i = 0; i < workspace.size; ++i)
+            spins[i] = workspace.spins[i];
+    }
+
+    void store(const Workspace &workspace, std::vector<bool> &spins) {
+        for (int i = 0; i < workspace.size; ++i)
+            spins[i] = workspace.spins[i] > 0;
+    }
+
+    static int findRoot(std::vector<int> &parent, int i) {
+        /** Path halving; parents only point to smaller indices, so concurrent halving cannot create cycles */
+        while (true) {
+            std::atomic_ref<int> link(parent[i]);
+            int p = link.load(std::memory_order_acquire);
+            if (p == i)
+                return i;
+            const int grandParent = std::atomic_ref<int>(parent[p]).load(std::memory_order_acquire);
+            if (grandParent != p)
+                link.compare_exchange_weak(p, grandParent, std::memory_order_acq_rel);
+            i = grandParent;
+        }
+    }
+
+    static void unite(std::vector<int> &parent, int a, int b) {
+        /** Link-by-index: the root with the larger index is attached (CAS) to the smaller one */
+        while (true) {
+            a = findRoot(parent, a);
+            b = findRoot(parent, b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            int expected = a;
+            if (std::atomic_ref<int>(parent[a]).compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+                return;
+        }
+    }
+
+    void monteCarloStep(Workspace &workspace,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down) {
+        /**
+         * Every site owns its bonds to the right (next) and lower (down) neighbour,
+         * so each bond is activated exactly once. previous/up are not needed.
+         */
+        (void) previous;
+        (void) up;
+        const int size = workspace.size;
+        const int threads = workspace.team->size();
+        auto range = [size, threads](int t) {
+            return std::pair<int, int>{static_cast<int>(static_cast<long long>(size) * t / threads),
+                                       static_cast<int>(static_cast<long long>(size) * (t + 1) / threads)};
+        };
+        int8_t *spins = workspace.spins.data();
+        std::vector<int> &parent = workspace.parent;
+
+        // 1) every site is its own cluster
+        workspace.team->run([&](int t) {
+            auto [begin, end] = range(t);
+            for (int i = begin; i < end; ++i)
+                parent[i] = i;
+        });
+
+        // 2) activate bonds between aligned neighbours and join their clusters
+        workspace.team->run([&](int t) {
+            auto [begin, end] = range(t);
+            pcg64 &rng = workspace.streams[t];
+            std::uniform_real_distribution<double> realDist{0.0, 1.0};
+            for (int i = begin; i < end; ++i) {
+                if (spins[i] == spins[next[i]] && realDist(rng) < workspace.bondProbability)
+                    unite(parent, i, next[i]);
+                if (spins[i] == spins[down[i]] && realDist(rng) < workspace.bondProbability)
+                    unite(parent, i, down[i]);
+            }
+        });
+
+        // 3) compress labels, every root draws the flip of its cluster
+        workspace.team->run([&](int t) {
+            auto [begin, end] = range(t);
+            pcg64 &rng = workspace.streams[t];
+            long long roots = 0;
+            for (int i = begin; i < end; ++i) {
+                const int root = findRoot(parent, i);
+                if (root == i) {
+                    workspace.flip[i] = static_cast<uint8_t>(rng() & 1);
+                    ++roots;
+                } else {
+                    std::atomic_ref<int>(parent[i]).store(root, std::memory_order_release);
+                }
+            }
+            workspace.counts[t] = roots;
+        });
+
+        // 4) apply the flips
+        workspace.team->run([&](int t) {
+            auto [begin, end] = range(t);
+            for (int i = begin; i < end; ++i)
+                if (workspace.flip[parent[i]])
+                    spins[i] = static_cast<int8_t>(-spins[i]);
+        });
+
+        for (const auto &roots : workspace.counts)
+            workspace.clusters += roots;
+        ++workspace.steps;
+    }
+
+    void thermalize(Workspace &workspace,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime) {
+        /** warmingTime is given in single-spin updates, one SW step updates every site */
+        const int sweeps = (warmingTime + workspace.size - 1) / workspace.size;
+        for (int k = 0; k < sweeps; ++k)
+            monteCarloStep(workspace, next, previous, up, down);
+        workspace.clusters = 0;
+        workspace.steps = 0;
+    }
+
+    double magnetization(Workspace &workspace) {
+        /** Average spin {-1,1} */
+        const int size = workspace.size;
+        const int threads = workspace.team->size();
+        workspace.team->run([&](int t) {
+            const int begin = static_cast<int>(static_cast<long long>(size) * t / threads);
+            const int end = static_cast<int>(static_cast<long long>(size) * (t + 1) / threads);
+            long long m = 0;
+            for (int i = begin; i < end; ++i)
+                m += workspace.spins[i];
+            workspace.counts[t] = m;
+        });
+        long long m = 0;
+        for (const auto &partial : workspace.counts)
+            m += partial;
+        return static_cast<double>(m) / size;
+    }
+
+    double meanClusters(const Workspace &workspace) {
+        return workspace.steps ? static_cast<double>(workspace.clusters) / workspace.steps : 0.0;
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_SWENDSENWANG_H
+#define ISING2021_SWENDSENWANG_H
+
+#include "Utils.h"
+#include "ThreadTeam.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace SwendsenWang {
+    /**
+     * Workspace of the multithreaded Swendsen-Wang algorithm.
+     * Spins are kept as int8 {-1,1} (both representations), so the threads can write them concurrently.
+     * parent[] is the union-find forest, accessed through std::atomic_ref by all the threads.
+     */
+    struct Workspace {
+        int size{};
+        double bondProbability{};         // 1 - exp(-2J/T)
+        std::vector<int8_t> spins;
+        std::vector<int> parent;
+        std::vector<uint8_t> flip;        // flip decision of every cluster (stored at its root)
+        std::vector<pcg64> streams;       // one random stream per thread
+        std::vector<long long> counts;    // per-thread partial results (roots, magnetization)
+        std::shared_ptr<ThreadTeam> team;   // shared by the workspaces of a worker
+        long long clusters{0};            // statistics since the last prepare
+        long long steps{0};
+    };
+
+    void init(Workspace &workspace, int size, std::shared_ptr<ThreadTeam> team);
+    void setTemperature(Workspace &workspace, const std::array<double, 5> &boltzmannCoeffs, pcg64 &rng);
+    void load(Workspace &workspace, const std::vector<int> &spins);
+    void load(Workspace &workspace, const std::vector<bool> &spins);
+    void store(const Workspace &workspace, std::vector<int> &spins);
+    void store(const Workspace &workspace, std::vector<bool> &spins);
+
+    void monteCarloStep(Workspace &workspace,
+                        const std::vector<int> &next,
+                        const std::vector<int> &previous,
+                        const std::vector<int> &up,
+                        const std::vector<int> &down);
+
+    void thermalize(Workspace &workspace,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime);
+
+    double magnetization(Workspace &workspace);
+    double meanClusters(const Workspace &workspace);
+}
+
+
+#endif //ISING2021_SWENDSENWANG_H
@@ -0,0 +1,222 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Tempering.h"
+#include "Seeding.h"
+#include "ThreadTeam.h"
+#include <algorithm>
+#include <memory>
+
+
+namespace Tempering {
+
+    struct Replica {
+        std::vector<int> spins;
+        SweepEngine engine;
+        std::array<double, 5> coefficients{};         // of its current temperature, exchanged with the thresholds
+        pcg64 rng;
+        std::uniform_real_distribution<double> realDist{0.0, 1.0};
+        std::uniform_int_distribution<int> intDist;
+        int direction{0};                             // +1 after the hottest, -1 after the coldest temperature
+        long long leftHottest{0};                     // sweep of the last arrival at the hottest temperature
+    };
+
+    double acceptance(const Statistics &statistics, size_t pair) {
+        return statistics.attempts[pair] ? static_cast<double>(statistics.accepted[pair]) / statistics.attempts[pair] : 0.0;
+    }
+
+    double meanRoundTrip(const Statistics &statistics) {
+        return statistics.roundTrips ? static_cast<double>(statistics.roundTripSweeps) / statistics.roundTrips : 0.0;
+    }
+
+    static void track(std::vector<Replica> &replicas, const std::vector<int> &replicaAt, long long sweep,
+                      Statistics &statistics) {
+        /** Round trips of the replicas between the ends of the grid (temperatures are descending) */
+        Replica &hottest = replicas[replicaAt.front()];
+        if (hottest.direction == -1) {
+            ++statistics.roundTrips;
+            statistics.roundTripSweeps += sweep - hottest.leftHottest;
+        }
+        if (hottest.direction != 1) {
+            hottest.direction = 1;
+            hottest.leftHottest = sweep;
+        }
+        Replica &coldest = replicas[replicaAt.back()];
+        if (coldest.direction == 1)
+            coldest.direction = -1;
+    }
+
+    static void exchange(std::vector<Replica> &replicas, std::vector<int> &replicaAt,
+                         const std::vector<double> &temperatures, long long round, pcg64 &rng,
+                         std::uniform_real_distribution<double> &realDist, Statistics &statistics) {
+        /** Deterministic even/odd scheme: the pairs (k, k+1) with k of the parity of the round */
+        for (size_t k = round % 2; k + 1 < temperatures.size(); k += 2) {
+            Replica &a = replicas[replicaAt[k]];
+            Replica &b = replicas[replicaAt[k + 1]];
+            const double delta = (1.0 / temperatures[k] - 1.0 / temperatures[k + 1])
+                                 * static_cast<double>(a.engine.totals.energy - b.engine.totals.energy);
+            ++statistics.attempts[k];
+            if (delta >= 0.0 || realDist(rng) < std::exp(delta)) {
+                ++statistics.accepted[k];
+                std::swap(a.engine.thresholds, b.engine.thresholds);
+                std::swap(a.coefficients, b.coefficients);
+                std::swap(replicaAt[k], replicaAt[k + 1]);
+            }
+        }
+    }
+
+    static void writeConfiguration(const std::vector<int> &spins, double T, bool standardIsing,
+                                   std::ostream &file, const std::string &separator) {
+        if (standardIsing) {
+            writeConfigurations(spins, T, file, separator);
+            return;
+        }
+        std::vector<bool> bits(spins.size());
+        for (size_t i = 0; i < spins.size(); ++i)
+            bits[i] = spins[i] > 0;
+        BoolSpinConfigurations::writeConfigurations(bits, T, file, separator);
+    }
+
+    static void pack(const std::vector<int> &spins, std::vector<uint64_t> &rows) {
+        /** Appends the configuration to rows, 1 bit per spin (set for up) */
+        const size_t start = rows.size();
+        rows.resize(start + (spins.size() + 63) / 64, 0);
+        for (size_t i = 0; i < spins.size(); ++i)
+            if (spins[i] > 0)
+                rows[start + i / 64] |= uint64_t{1} << (i % 64);
+    }
+
+    static void unpack(const std::vector<uint64_t> &rows, size_t row, std::vector<int> &spins) {
+        const size_t start = row * ((spins.size() + 63) / 64);
+        for (size_t i = 0; i < spins.size(); ++i)
+            spins[i] = (rows[start + i / 64] >> (i % 64)) & 1 ? 1 : -1;
+    }
+
+    void simulate(const std::vector<double> &temperatures,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  Boundary boundary,
+                  uint64_t seed,
+                  int MCS,
+                  int warmingTime,
+                  int takeEvery,
+                  int exchangeEvery,
+                  int threads,
+                  bool standardIsing,
+                  bool saveData,
+                  std::ostream &file,
+                  const std::string &separator,
+                  std::vector<Observables::Accumulator> &observables,
+                  Statistics &statistics) {
+        /**
+         * Replica k starts at temperature k with the stream Seeding::stream(seed, L, k), the swaps use the stream
+         * number temperatures.size(), so the run does not depend on the number of threads.
+         * warmingTime (single-spin updates) is spent in sweeps with exchanges, the statistics start afterwards.
+         * The saved configurations are kept bit-packed per temperature and written in temperature blocks at the end,
+         * the layout of the other methods.
+         */
+        const int size = L * L;
+        const auto count = static_cast<int>(temperatures.size());
+        std::vector<Replica> replicas(count);
+        std::vector<int> replicaAt(count);
+        std::uniform_int_distribution<int> choice{0, 1};
+        for (int k = 0; k < count; ++k) {
+            Replica &replica = replicas[k];
+            replica.rng = Seeding::stream(seed, L, k);
+            replica.intDist = std::uniform_int_distribution<int>{0, size - 1};
+            replica.spins.assign(size, 0);
+            replica.engine.boundary = boundary;
+            if (boundary == Boundary::Helical)
+                Helical::init(replica.engine.helical, L);
+            replica.coefficients = MetropolisRSU::calculateBoltzmannCoeff(temperatures[k]);
+            MetropolisRSU::initState(replica.spins, replica.rng, choice);
+            MetropolisRSU::prepare(replica.engine, replica.spins, next, down, replica.coefficients, replica.rng);
+            replicaAt[k] = k;
+        }
+        pcg64 rng = Seeding::stream(seed, L, temperatures.size());
+        std::uniform_real_distribution<double> realDist{0.0, 1.0};
+
+        const int members = std::clamp(threads, 1, count);
+        std::unique_ptr<ThreadTeam> team;
+        if (members > 1)
+            team = std::make_unique<ThreadTeam>(members);
+        const std::function<void(int)> sweep = [&](int member) {
+            for (int r = member; r < count; r += members) {
+                Replica &replica = replicas[r];
+                MetropolisRSU::monteCarloStep(replica.engine, size, replica.spins, next, previous, up, down,
+                                              replica.rng, replica.realDist, replica.intDist);
+            }
+        };
+
+        long long round = 0;
+        auto step = [&](long long sweepIndex) {
+            if (team)
+                team->run(sweep);
+            else
+                sweep(0);
+            if ((sweepIndex + 1) % exchangeEvery == 0) {
+                exchange(replicas, replicaAt, temperatures, round++, rng, realDist, statistics);
+                track(replicas, replicaAt, sweepIndex + 1, statistics);
+            }
+        };
+
+        statistics = Statistics{};
+        statistics.attempts.assign(std::max(0, count - 1), 0);
+        statistics.accepted.assign(std::max(0, count - 1), 0);
+        const long long warmingSweeps = (warmingTime + size - 1) / size;
+        for (long long s = 0; s < warmingSweeps; ++s)
+            step(s);
+        statistics = Statistics{};
+        statistics.attempts.assign(std::max(0, count - 1), 0);
+        statistics.accepted.assign(std::max(0, count - 1), 0);
+        for (Replica &replica : replicas)
+            replica.direction = 0;
+        track(replicas, replicaAt, 0, statistics);
+
+        observables.resize(count);
+        for (auto &accumulator : observables)
+            Observables::reset(accumulator);
+        std::vector<std::vector<uint64_t>> kept(saveData ? 0 : count);
+        for (int i = 0; i <= MCS; ++i) {
+            step(i);
+            if (i % takeEvery != 0)
+                continue;
+            for (int k = 0; k < count; ++k) {
+                Replica &replica = replicas[replicaAt[k]];
+                Observables::add(observables[k], static_cast<double>(replica.engine.totals.magnetization) / size,
+                                 static_cast<double>(replica.engine.totals.energy) / size);
+                if (!saveData) {
+                    MetropolisRSU::synchronize(replica.engine, replica.spins);
+                    pack(replica.spins, kept[k]);
+                }
+            }
+        }
+
+        if (!saveData) {
+            std::vector<int> spins(size);
+            for (int k = 0; k < count; ++k)
+                for (size_t row = 0; row * ((size + 63) / 64) < kept[k].size(); ++row) {
+                    unpack(kept[k], row, spins);
+                    writeConfiguration(spins, temperatures[k], standardIsing, file, separator);
+                }
+            return;
+        }
+        for (int k = 0; k < count; ++k) {
+            Replica &replica = replicas[replicaAt[k]];
+            MetropolisRSU::synchronize(replica.engine, replica.spins);
+            const auto summary = Observables::summarize(observables[k], temperatures[k], size);
+            if (standardIsing) {
+                writeData(replica.spins, summary, temperatures[k], file, separator);
+            } else {
+                std::vector<bool> bits(size);
+                for (int i = 0; i < size; ++i)
+                    bits[i] = replica.spins[i] > 0;
+                BoolSpinConfigurations::writeData(bits, summary, temperatures[k], file, separator);
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_TEMPERING_H
+#define ISING2021_TEMPERING_H
+
+#include "Models.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Tempering {
+    /**
+     * Parallel tempering (replica exchange): one single-spin replica per temperature, all of them swept
+     * in parallel, and swaps of neighbouring temperatures attempted between the sweeps with the probability
+     * min(1, exp((1/T_k - 1/T_k+1) (E_k - E_k+1))). Only the temperatures (acceptance thresholds) are exchanged,
+     * the configurations stay in place.
+     */
+    struct Statistics {
+        std::vector<long long> attempts;              // per neighbour pair (k, k+1) of the temperature grid
+        std::vector<long long> accepted;
+        long long roundTrips{0};                      // hottest -> coldest -> hottest temperature
+        long long roundTripSweeps{0};                 // sum of their durations
+    };
+
+    double acceptance(const Statistics &statistics, size_t pair);
+    double meanRoundTrip(const Statistics &statistics);
+
+    // Writes the configurations of every temperature each takeEvery sweeps (in temperature blocks),
+    // or with saveData the last configuration of every temperature with its observables
+    void simulate(const std::vector<double> &temperatures,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  Boundary boundary,
+                  uint64_t seed,
+                  int MCS,
+                  int warmingTime,
+                  int takeEvery,
+                  int exchangeEvery,
+                  int threads,
+                  bool standardIsing,
+                  bool saveData,
+                  std::ostream &file,
+                  const std::string &separator,
+                  std::vector<Observables::Accumulator> &observables,
+                  Statistics &statistics);
+}
+
+
+#endif //ISING2021_TEMPERING_H
@@ -0,0 +1,195 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISINGMODEL_THREADPOOL_H
+#define ISINGMODEL_THREADPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+    /**
+     * Executor for independent tasks (e.g. one task per temperature).
+     * Every worker has its own queue; tasks are dealt round-robin, a worker takes tasks from the front
+     * of its queue and, when it runs dry, steals from the back of the queues of the other workers.
+     */
+        private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        size_t m_next{0};         // queue receiving the next task
+        long m_queued{0};         // tasks waiting in the queues
+        long m_pending{0};        // tasks submitted and not finished
+        bool m_stop{false};
+
+        static int &currentWorker()
+        {
+            thread_local int worker = -1;
+            return worker;
+        }
+
+        bool tryPop(size_t self, std::function<void()> &task)
+        {
+            for (size_t k = 0; k < m_queues.size(); ++k) {
+                Queue &queue = *m_queues[(self + k) % m_queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                    continue;
+                if (k == 0) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                } else {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void work(size_t self)
+        {
+            currentWorker() = static_cast<int>(self);
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stop || m_queued > 0; });
+                    if (m_stop && m_queued == 0)
+                        return;
+                }
+                std::function<void()> task;
+                if (!tryPop(self, task))
+                    continue;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    --m_queued;
+                }
+                task();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_pending == 0)
+                    m_idle.notify_all();
+            }
+        }
+
+        public:
+        explicit WorkStealingPool(int threads)
+        {
+            for (int t = 0; t < std::max(1, threads); ++t)
+                m_queues.push_back(std::make_unique<Queue>());
+            for (size_t t = 0; t < m_queues.size(); ++t)
+                m_workers.emplace_back(&WorkStealingPool::work, this, t);
+        }
+
+        ~WorkStealingPool()
+        {
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto &worker : m_workers)
+                worker.join();
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        [[nodiscard]] int size() const
+        {
+            return static_cast<int>(m_workers.size());
+        }
+
+        [[nodiscard]] static int current()
+        {
+            /** Index of the worker running the calling thread, -1 outside of the pools */
+            return currentWorker();
+        }
+
+        void submit(std::function<void()> task)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Queue &queue = *m_queues[m_next];
+            m_next = (m_next + 1) % m_queues.size();
+            {
+                std::lock_guard<std::mutex> queueLock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            ++m_queued;
+            ++m_pending;
+            m_wake.notify_one();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [&] { return m_pending == 0; });
+        }
+};
+
+
+template<typename Task>
+void runInOrder(WorkStealingPool &pool, size_t count, std::ostream &out, Task task)
+{
+    /**
+     * Runs task(k, data, log) for k = 0..count-1 on the pool. Every task writes to its own buffers,
+     * which are copied to out (data) and std::cout (log) strictly in the order of k, as soon as they are ready,
+     * so the output does not depend on the number of threads.
+     * At most two tasks per worker are in flight: the task k + window is submitted once the task k is written,
+     * so a slow early task holds back a bounded number of finished buffers.
+     */
+    const size_t window = std::min(count, 2 * static_cast<size_t>(pool.size()));
+    std::vector<std::ostringstream> data(window);
+    std::vector<std::ostringstream> log(window);
+    std::vector<char> ready(window, 0);
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    auto submit = [&](size_t k) {
+        pool.submit([&, k] {
+            task(k, data[k % window], log[k % window]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[k % window] = 1;
+            }
+            finished.notify_all();
+        });
+    };
+
+    for (size_t k = 0; k < window; ++k)
+        submit(k);
+    for (size_t k = 0; k < count; ++k) {
+        const size_t slot = k % window;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return ready[slot] != 0; });
+            ready[slot] = 0;
+        }
+        out << data[slot].str();
+        std::cout << log[slot].str() << std::flush;
+        data[slot] = std::ostringstream{};
+        log[slot] = std::ostringstream{};
+        if (k + window < count)
+            submit(k + window);
+    }
+    pool.wait();
+}
+
+
+#endif //ISINGMODEL_THREADPOOL_H
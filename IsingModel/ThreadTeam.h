@@ -0,0 +1,92 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISINGMODEL_THREADTEAM_H
+#define ISINGMODEL_THREADTEAM_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadTeam {
+    /**
+     * Fixed group of threads for data-parallel phases of a sweep (fork-join).
+     * run(task) calls task(t) for t = 0..size()-1, member 0 is the calling thread,
+     * and returns when every member has finished.
+     */
+        private:
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_start;
+        std::condition_variable m_done;
+        const std::function<void(int)> *m_task{nullptr};
+        unsigned long m_generation{0};
+        int m_pending{0};
+        bool m_stop{false};
+
+        void work(int member)
+        {
+            unsigned long seen = 0;
+            while (true) {
+                const std::function<void(int)> *task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+                    if (m_stop)
+                        return;
+                    seen = m_generation;
+                    task = m_task;
+                }
+                (*task)(member);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_pending == 0)
+                    m_done.notify_one();
+            }
+        }
+
+        public:
+        explicit ThreadTeam(int threads)
+        {
+            for (int t = 1; t < threads; ++t)
+                m_workers.emplace_back(&ThreadTeam::work, this, t);
+        }
+
+        ~ThreadTeam()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_start.notify_all();
+            for (auto &worker : m_workers)
+                worker.join();
+        }
+
+        ThreadTeam(const ThreadTeam &) = delete;
+        ThreadTeam &operator=(const ThreadTeam &) = delete;
+
+        [[nodiscard]] int size() const
+        {
+            return static_cast<int>(m_workers.size()) + 1;
+        }
+
+        void run(const std::function<void(int)> &task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_task = &task;
+                m_pending = static_cast<int>(m_workers.size());
+                ++m_generation;
+            }
+            m_start.notify_all();
+            task(0);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_pending == 0; });
+        }
+};
+
+
+#endif //ISINGMODEL_THREADTEAM_H
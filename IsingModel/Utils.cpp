@@ -3,6 +3,7 @@
 //
 
 #include "Utils.h"
+#include <fstream>
 
 int getRandomChoice(pcg64 &rng, std::uniform_int_distribution<int> &dist) {
     /** Get random integer from ~U{-1,1} */
@@ -11,6 +12,76 @@ int getRandomChoice(pcg64 &rng, std::uniform_int_distribution<int> &dist) {
 }
 
 
+std::map<std::string, std::string> parseOptions(int argc, char **argv, int first) {
+    /** Collect optional "key=value" arguments given after the positional ones */
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg{argv[i]};
+        auto pos = arg.find('=');
+        if (pos == std::string::npos) {
+            std::cerr << "Ignoring argument '" << arg << "' (expected key=value)\n";
+            continue;
+        }
+        options[arg.substr(0, pos)] = arg.substr(pos + 1);
+    }
+    return options;
+}
+
+std::string getOption(const std::map<std::string, std::string> &options, const std::string &key, const std::string &defaultValue) {
+    auto it = options.find(key);
+    return it == options.end() ? defaultValue : it->second;
+}
+
+bool parseInteger(const std::string &text, int &value) {
+    /** The whole text has to be an integer, value is left unchanged otherwise */
+    std::istringstream stream{text};
+    int parsed;
+    if (!(stream >> parsed) || !(stream >> std::ws).eof())
+        return false;
+    value = parsed;
+    return true;
+}
+
+bool parseDouble(const std::string &text, double &value) {
+    /** The whole text has to be a number, value is left unchanged otherwise */
+    std::istringstream stream{text};
+    double parsed;
+    if (!(stream >> parsed) || !(stream >> std::ws).eof())
+        return false;
+    value = parsed;
+    return true;
+}
+
+
+std::string metadataFileName(const std::string &dataFileName) {
+    /** Data_C_L20_MCS200000_WT20000.txt -> Data_C_L20_MCS200000_WT20000_meta.txt */
+    auto dot = dataFileName.find_last_of('.');
+    return dataFileName.substr(0, dot) + "_meta.txt";
+}
+
+std::string seriesFileName(const std::string &dataFileName) {
+    /** Data_A_L20_MCS200000_WT20000.txt -> Data_A_L20_MCS200000_WT20000_series.bin */
+    auto dot = dataFileName.find_last_of('.');
+    return dataFileName.substr(0, dot) + "_series.bin";
+}
+
+void writeMetadata(const std::string &dataFileName, const Metadata &metadata) {
+    /**
+     * The data files are opened in appending mode, so is the metadata:
+     * every run adds its own block, in the same order as the rows it appended to the data file
+     */
+    std::ofstream file{metadataFileName(dataFileName), std::ios::app};
+    if (!file) {
+        std::cerr << metadataFileName(dataFileName) << " could not be opened for writing!\n";
+        return;
+    }
+    file << "[run]\n";
+    for (const auto &[key, value] : metadata)
+        file << key << " = " << value << "\n";
+    file << "\n";
+}
+
+
 std::string generateFileName(const std::string& Quantity, int L, int MCS, int warmingTime, int saveMode, double T = 0.0, const std::string& format = ".csv") {
     /** Helper fcn for creating name of the data file */
     std::ostringstream name;
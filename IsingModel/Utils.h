@@ -10,11 +10,24 @@
 #include <string>
 #include <sstream>
 #include <iomanip>      // std::setprecision
+#include <map>
+#include <utility>
+#include <vector>
 
 
 
 
 int getRandomChoice(pcg64 &rng, std::uniform_int_distribution<int> &dist);
+std::map<std::string, std::string> parseOptions(int argc, char **argv, int first);
+std::string getOption(const std::map<std::string, std::string> &options, const std::string &key, const std::string &defaultValue);
+bool parseInteger(const std::string &text, int &value);
+bool parseDouble(const std::string &text, double &value);
+// Ordered "key = value" entries describing a run, written next to the data file
+using Metadata = std::vector<std::pair<std::string, std::string>>;
+std::string metadataFileName(const std::string &dataFileName);
+std::string seriesFileName(const std::string &dataFileName);
+void writeMetadata(const std::string &dataFileName, const Metadata &metadata);
+
 std::string generateFileName(const std::string& Quantity, int L, int MCS, int warmingTime, int saveMode, double T, const std::string& format);
 
 #endif //ISING2021_UTILS_H
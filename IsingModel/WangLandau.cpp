@@ -0,0 +1,337 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "WangLandau.h"
+#include "RandomBuffer.h"
+#include "Seeding.h"
+#include "ThreadTeam.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+
+namespace WangLandau {
+
+    struct Walker {
+        int begin{}, end{};                           // energy bins [begin, end)
+        std::vector<int8_t> spins;
+        long long energy{}, magnetization{};
+        std::vector<double> logG;
+        std::vector<long long> histogram;
+        std::vector<char> visited;
+        RandomBuffer::Buffer random;
+        int stages{0};
+        std::vector<double> sumAbsM, sumM2, sumM4;
+        std::vector<long long> counts;
+        std::vector<std::vector<std::vector<bool>>> samples;
+    };
+
+    struct Geometry {
+        const std::vector<int> &next, &previous, &up, &down;
+        long long minimumEnergy;
+    };
+
+    static double uniform(RandomBuffer::Buffer &random) {
+        return (static_cast<double>(RandomBuffer::next(random)) + 0.5) * 0x1p-32;
+    }
+
+    static int energyChange(const Walker &walker, const Geometry &geometry, int i) {
+        const int h = walker.spins[geometry.next[i]] + walker.spins[geometry.previous[i]] +
+                      walker.spins[geometry.up[i]] + walker.spins[geometry.down[i]];
+        return 2 * walker.spins[i] * h;
+    }
+
+    static int bin(const Geometry &geometry, long long energy) {
+        return static_cast<int>((energy - geometry.minimumEnergy) / 4);
+    }
+
+    static void flip(Walker &walker, int i, int dE) {
+        walker.magnetization -= 2 * walker.spins[i];
+        walker.energy += dE;
+        walker.spins[i] = static_cast<int8_t>(-walker.spins[i]);
+    }
+
+    static void enterWindow(Walker &walker, const Geometry &geometry) {
+        /** From the ground state (all up) random flips that do not lower the energy until the window is reached */
+        const auto size = static_cast<uint32_t>(walker.spins.size());
+        while (bin(geometry, walker.energy) < walker.begin) {
+            const auto i = static_cast<int>(RandomBuffer::bounded(walker.random, size));
+            const int dE = energyChange(walker, geometry, i);
+            if (dE >= 0 && bin(geometry, walker.energy + dE) < walker.end)
+                flip(walker, i, dE);
+        }
+    }
+
+    static bool flat(const Walker &walker, double flatness) {
+        long long total = 0, lowest = std::numeric_limits<long long>::max();
+        int bins = 0;
+        for (int b = walker.begin; b < walker.end; ++b) {
+            if (!walker.visited[b])
+                continue;
+            total += walker.histogram[b];
+            lowest = std::min(lowest, walker.histogram[b]);
+            ++bins;
+        }
+        return bins > 0 && static_cast<double>(lowest) >= flatness * static_cast<double>(total) / bins;
+    }
+
+    static void move(Walker &walker, const Geometry &geometry, double logF) {
+        /** Single-spin flip with the probability min(1, g(E) / g(E')), restricted to the window */
+        const auto i = static_cast<int>(RandomBuffer::bounded(walker.random, static_cast<uint32_t>(walker.spins.size())));
+        const int dE = energyChange(walker, geometry, i);
+        const int from = bin(geometry, walker.energy);
+        const int to = bin(geometry, walker.energy + dE);
+        if (to >= walker.begin && to < walker.end) {
+            const double difference = walker.logG[from] - walker.logG[to];
+            if (difference >= 0.0 || uniform(walker.random) < std::exp(difference))
+                flip(walker, i, dE);
+        }
+        const int now = bin(geometry, walker.energy);
+        walker.logG[now] += logF;
+        ++walker.histogram[now];
+        walker.visited[now] = 1;
+    }
+
+    static void run(Walker &walker, const Geometry &geometry, const Settings &settings) {
+        const int size = static_cast<int>(walker.spins.size());
+        enterWindow(walker, geometry);
+
+        // refinement: ln f -> ln f / 2 every time the histogram of the window is flat
+        for (double logF = 1.0; logF >= settings.finalLogF; logF /= 2.0, ++walker.stages) {
+            std::fill(walker.histogram.begin(), walker.histogram.end(), 0);
+            do {
+                for (int k = 0; k < 10 * size; ++k)
+                    move(walker, geometry, logF);
+            } while (!flat(walker, settings.flatness));
+        }
+
+        // multicanonical production with fixed g: microcanonical moments of m and the reservoirs
+        for (int sweep = 0; sweep < settings.productionSweeps; ++sweep) {
+            for (int k = 0; k < size; ++k)
+                move(walker, geometry, 0.0);
+            const int b = bin(geometry, walker.energy);
+            const double m = static_cast<double>(walker.magnetization) / size;
+            walker.sumAbsM[b] += std::abs(m);
+            walker.sumM2[b] += m * m;
+            walker.sumM4[b] += m * m * m * m;
+            const long long seen = ++walker.counts[b];
+            // reservoir sampling keeps a uniform subset of the visits of every energy
+            auto &kept = walker.samples[b];
+            const long long slot = seen <= settings.reservoir ? seen - 1
+                                                              : RandomBuffer::bounded(walker.random, static_cast<uint32_t>(seen));
+            if (slot < settings.reservoir) {
+                std::vector<bool> configuration(size);
+                for (int i = 0; i < size; ++i)
+                    configuration[i] = walker.spins[i] > 0;
+                if (slot < static_cast<long long>(kept.size()))
+                    kept[slot] = std::move(configuration);
+                else
+                    kept.push_back(std::move(configuration));
+            }
+        }
+    }
+
+    void estimate(DensityOfStates &states,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  uint64_t seed,
+                  const Settings &settings) {
+        /**
+         * Walker w uses the stream Seeding::stream(seed, L, w), so the result does not depend on the threads.
+         * Windows of 2B/(W+1) bins start every B/(W+1) bins (half overlap). The ln g of the next window is shifted
+         * by the mean difference over the common visited bins and takes over from the middle of the overlap.
+         */
+        const int size = L * L;
+        const long long minimumEnergy = -2LL * size;
+        const long long maximumEnergy = std::max(minimumEnergy + 8, std::llround(settings.maximumEnergy * size));
+        const int bins = static_cast<int>((maximumEnergy - minimumEnergy) / 4) + 1;
+        const Geometry geometry{next, previous, up, down, minimumEnergy};
+        const int count = std::clamp(settings.walkers, 1, std::max(1, bins / 8));
+        // bins * reservoir configurations of size bits at most
+        Settings production = settings;
+        const double perConfiguration = static_cast<double>(bins) * size / 8.0;
+        const double affordable = std::floor(settings.reservoirMegabytes * 1024.0 * 1024.0 / perConfiguration);
+        production.reservoir = static_cast<int>(std::clamp(affordable, 1.0, static_cast<double>(settings.reservoir)));
+
+        std::vector<Walker> walkers(count);
+        for (int w = 0; w < count; ++w) {
+            Walker &walker = walkers[w];
+            walker.begin = static_cast<int>(std::lround(static_cast<double>(w) * bins / (count + 1)));
+            walker.end = std::min(bins, static_cast<int>(std::lround(static_cast<double>(w + 2) * bins / (count + 1))));
+            walker.spins.assign(size, 1);
+            walker.energy = minimumEnergy;
+            walker.magnetization = size;
+            walker.logG.assign(bins, 0.0);
+            walker.histogram.assign(bins, 0);
+            walker.visited.assign(bins, 0);
+            walker.sumAbsM.assign(bins, 0.0);
+            walker.sumM2.assign(bins, 0.0);
+            walker.sumM4.assign(bins, 0.0);
+            walker.counts.assign(bins, 0);
+            walker.samples.assign(bins, {});
+            pcg64 rng = Seeding::stream(seed, L, w);
+            RandomBuffer::seed(walker.random, rng);
+        }
+
+        const int members = std::clamp(settings.threads, 1, count);
+        std::unique_ptr<ThreadTeam> team;
+        if (members > 1)
+            team = std::make_unique<ThreadTeam>(members);
+        const std::function<void(int)> task = [&](int member) {
+            for (int w = member; w < count; w += members)
+                run(walkers[w], geometry, production);
+        };
+        if (team)
+            team->run(task);
+        else
+            task(0);
+
+        // join the windows
+        const double missing = -std::numeric_limits<double>::infinity();
+        states.size = size;
+        states.minimumEnergy = minimumEnergy;
+        states.logG.assign(bins, missing);
+        states.absM.assign(bins, 0.0);
+        states.m2.assign(bins, 0.0);
+        states.m4.assign(bins, 0.0);
+        states.visits.assign(bins, 0);
+        states.samples.assign(bins, {});
+        states.drawn.assign(bins, 0);
+        states.reservoir = production.reservoir;
+        states.exhausted = -1;
+        states.stages.clear();
+        int from = 0;
+        for (int w = 0; w < count; ++w) {
+            Walker &walker = walkers[w];
+            states.stages.push_back(walker.stages);
+            if (w > 0) {
+                // the preceding walker is already shifted
+                const Walker &preceding = walkers[w - 1];
+                double difference = 0.0;
+                int common = 0;
+                for (int b = walker.begin; b < preceding.end; ++b)
+                    if (walker.visited[b] && preceding.visited[b]) {
+                        difference += preceding.logG[b] - walker.logG[b];
+                        ++common;
+                    }
+                const double shift = common ? difference / common : 0.0;
+                for (double &value : walker.logG)
+                    value += shift;
+            }
+            const int to = w + 1 < count ? (walkers[w + 1].begin + walker.end) / 2 : walker.end;
+            for (int b = from; b < to; ++b) {
+                if (!walker.visited[b])
+                    continue;
+                states.logG[b] = walker.logG[b];
+                states.visits[b] = walker.counts[b];
+                if (walker.counts[b]) {
+                    states.absM[b] = walker.sumAbsM[b] / walker.counts[b];
+                    states.m2[b] = walker.sumM2[b] / walker.counts[b];
+                    states.m4[b] = walker.sumM4[b] / walker.counts[b];
+                }
+                states.samples[b] = std::move(walker.samples[b]);
+            }
+            from = to;
+        }
+
+        // two ground states
+        const double ground = states.logG[0];
+        for (double &value : states.logG)
+            value += std::log(2.0) - ground;
+    }
+
+    static std::vector<double> logWeights(const DensityOfStates &states, double T, double &largest) {
+        std::vector<double> weights(states.logG.size());
+        largest = -std::numeric_limits<double>::infinity();
+        for (size_t b = 0; b < weights.size(); ++b) {
+            weights[b] = states.logG[b] - static_cast<double>(states.minimumEnergy + 4 * static_cast<long long>(b)) / T;
+            largest = std::max(largest, weights[b]);
+        }
+        return weights;
+    }
+
+    Observables::Summary canonical(const DensityOfStates &states, double T) {
+        /**
+         * <X> = sum_E g(E) exp(-E/T) <X>_E / Z, with the largest exponent factored out.
+         * The moments of m are normalised over the energies the production visited, an energy seen only during
+         * the refinement has g(E) but no <X>_E.
+         */
+        double largest;
+        const std::vector<double> weights = logWeights(states, T, largest);
+        double Z = 0.0, Zm = 0.0, e = 0.0, e2 = 0.0, absM = 0.0, m2 = 0.0, m4 = 0.0;
+        for (size_t b = 0; b < weights.size(); ++b) {
+            if (states.logG[b] == -std::numeric_limits<double>::infinity())
+                continue;
+            const double w = std::exp(weights[b] - largest);
+            const double energy = static_cast<double>(states.minimumEnergy + 4 * static_cast<long long>(b)) / states.size;
+            Z += w;
+            e += w * energy;
+            e2 += w * energy * energy;
+            if (states.visits[b] == 0)
+                continue;
+            Zm += w;
+            absM += w * states.absM[b];
+            m2 += w * states.m2[b];
+            m4 += w * states.m4[b];
+        }
+        e /= Z; e2 /= Z;
+        if (Zm > 0.0) {
+            absM /= Zm; m2 /= Zm; m4 /= Zm;
+        }
+
+        Observables::Summary summary;
+        summary.samples = 0;
+        summary.absMagnetization = absM;
+        summary.energy = e;
+        summary.susceptibility = states.size * (m2 - absM * absM) / T;
+        summary.specificHeat = states.size * (e2 - e * e) / (T * T);
+        summary.binder = m2 > 0.0 ? 1.0 - m4 / (3.0 * m2 * m2) : 0.0;
+        return summary;
+    }
+
+    const std::vector<bool> *sample(DensityOfStates &states, double T, pcg64 &rng) {
+        /**
+         * The energy is drawn over every energy with a reservoir, so using configurations up does not shift the
+         * distribution: a drawn energy without unused configurations ends the draws instead of moving elsewhere.
+         */
+        double largest;
+        const std::vector<double> weights = logWeights(states, T, largest);
+        std::vector<double> cumulative(weights.size(), 0.0);
+        double total = 0.0;
+        for (size_t b = 0; b < weights.size(); ++b) {
+            if (!states.samples[b].empty())
+                total += std::exp(weights[b] - largest);
+            cumulative[b] = total;
+        }
+        states.exhausted = -1;
+        if (!(total > 0.0))
+            return nullptr;
+        std::uniform_real_distribution<double> realDist{0.0, total};
+        const double pick = realDist(rng);
+        auto b = static_cast<size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin());
+        b = std::min(b, weights.size() - 1);
+        while (states.samples[b].empty())
+            --b;
+        auto &kept = states.samples[b];
+        const size_t unused = kept.size() - states.drawn[b];
+        if (unused == 0) {
+            states.exhausted = static_cast<int>(b);
+            return nullptr;
+        }
+        // swap the chosen configuration behind the unused ones
+        std::uniform_int_distribution<size_t> choice{0, unused - 1};
+        std::swap(kept[choice(rng)], kept[unused - 1]);
+        ++states.drawn[b];
+        return &kept[unused - 1];
+    }
+
+    void rewind(DensityOfStates &states) {
+        std::fill(states.drawn.begin(), states.drawn.end(), 0);
+        states.exhausted = -1;
+    }
+}
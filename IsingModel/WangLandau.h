@@ -0,0 +1,67 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_WANGLANDAU_H
+#define ISING2021_WANGLANDAU_H
+
+#include "Utils.h"
+#include "Observables.h"
+#include <cstdint>
+#include <vector>
+
+
+namespace WangLandau {
+    /**
+     * Wang-Landau estimate of the density of states g(E) with one walker per overlapping energy window
+     * (Vogel, Li, Wuest & Landau), walkers run in parallel and their ln g are joined in the overlaps.
+     * After the last refinement a multicanonical pass with fixed g collects the microcanonical moments of m
+     * and a reservoir of configurations per energy, so any temperature can be reweighted and sampled afterwards.
+     * Within one temperature every stored configuration is drawn at most once (rewind before the next temperature).
+     * The reservoirs of all the energies together stay within reservoirMegabytes (1 bit per spin).
+     * The energies E = -sum over the bonds of s_i * s_j are binned by 4, from the ground state up to maximumEnergy.
+     */
+    struct Settings {
+        int walkers{1};
+        int threads{1};
+        double finalLogF{1e-6};       // ln f of the last refinement
+        double flatness{0.8};         // min H(E) >= flatness * <H(E)> over the visited energies
+        int productionSweeps{10000};  // multicanonical sweeps per walker after the refinement
+        int reservoir{16};            // configurations kept per energy (at least the draws of one temperature)
+        double reservoirMegabytes{1024.0};  // bound of all the reservoirs together, lowers reservoir if needed
+        double maximumEnergy{0.0};    // per site, the energies above have negligible weight for T < ~4
+    };
+
+    struct DensityOfStates {
+        int size{};
+        long long minimumEnergy{};
+        std::vector<double> logG;                     // -infinity for the energies never visited
+        std::vector<double> absM, m2, m4;             // microcanonical <|m|>, <m^2>, <m^4>
+        std::vector<long long> visits;                // production sweeps behind the moments of every energy
+        std::vector<std::vector<std::vector<bool>>> samples;
+        std::vector<size_t> drawn;                    // configurations of every reservoir already handed out
+        int reservoir{};                              // configurations kept per energy within the memory bound
+        int exhausted{-1};                            // energy whose reservoir ended the last draws
+        std::vector<int> stages;                      // refinements of every walker
+    };
+
+    void estimate(DensityOfStates &states,
+                  int L,
+                  const std::vector<int> &next,
+                  const std::vector<int> &previous,
+                  const std::vector<int> &up,
+                  const std::vector<int> &down,
+                  uint64_t seed,
+                  const Settings &settings);
+
+    // Canonical averages at T from g(E) and the microcanonical moments
+    Observables::Summary canonical(const DensityOfStates &states, double T);
+    // Configuration drawn from the canonical distribution at T (energy from g(E) exp(-E/T), then an unused one of
+    // the reservoir), nullptr once the reservoir of the drawn energy is used up or nothing was stored
+    const std::vector<bool> *sample(DensityOfStates &states, double T, pcg64 &rng);
+    // Every stored configuration can be drawn again, called before the draws of a temperature
+    void rewind(DensityOfStates &states);
+}
+
+
+#endif //ISING2021_WANGLANDAU_H
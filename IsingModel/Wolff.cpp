@@ -0,0 +1,223 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#include "Wolff.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace Wolff {
+/** ************************************************************************
+ *
+ * Wolff single-cluster updates (both spin representations)
+ * Used near Tc, where the single-spin updates suffer from critical slowing down
+ *
+ * *************************************************************************
+ * */
+
+    void init(Cluster &cluster, int size) {
+        cluster.stack.assign(size, 0);
+        cluster.visited.assign(size, 0);
+        cluster.generation = 0;
+        resetStatistics(cluster);
+    }
+
+    void load(Cluster &cluster, const std::vector<int> &spins) {
+        cluster.magnetization = 0;
+        for (const int spin : spins)
+            cluster.magnetization += spin;
+    }
+
+    void load(Cluster &cluster, const std::vector<bool> &spins) {
+        const auto up = std::count(spins.begin(), spins.end(), true);
+        cluster.magnetization = 2 * static_cast<long long>(up) - static_cast<long long>(spins.size());
+    }
+
+    void setTemperature(Cluster &cluster, const std::array<double, 5> &boltzmannCoeffs) {
+        /** boltzmannCoeffs[3] = exp(-4/T), so the bond probability 1 - exp(-2/T) = 1 - sqrt(boltzmannCoeffs[3]) */
+        cluster.addProbability = 1.0 - std::sqrt(boltzmannCoeffs[3]);
+    }
+
+    void resetStatistics(Cluster &cluster) {
+        cluster.clusters = 0;
+        cluster.flipped = 0;
+    }
+
+    void calibrate(Cluster &cluster, int size) {
+        /** Fix the number of clusters per MCS from the clusters grown so far, so one MCS flips ~size spins */
+        const double perStep = static_cast<double>(size) / meanClusterSize(cluster);
+        cluster.clustersPerStep = std::max(1, static_cast<int>(std::lround(perStep)));
+        resetStatistics(cluster);
+    }
+
+    double meanClusterSize(const Cluster &cluster) {
+        return cluster.clusters ? static_cast<double>(cluster.flipped) / cluster.clusters : 0.0;
+    }
+
+    static int flippedSpin(int spin) { return -spin; }
+    static bool flippedSpin(bool spin) { return !spin; }
+    static int spinValue(int spin) { return spin; }
+    static int spinValue(bool spin) { return spin ? 1 : -1; }
+
+    template<typename Spin>
+    static int growCluster(Cluster &cluster,
+                           std::vector<Spin> &spins,
+                           const std::vector<int> &next,
+                           const std::vector<int> &previous,
+                           const std::vector<int> &up,
+                           const std::vector<int> &down,
+                           pcg64 &rng,
+                           std::uniform_real_distribution<double> &realDist,
+                           std::uniform_int_distribution<int> &intDist) {
+        /**
+         * Grow the cluster from a random seed: aligned neighbours join with the probability addProbability.
+         * Every site is pushed at most once, so the stack never exceeds the lattice size.
+         */
+        if (++cluster.generation == 0) {   // stamps wrapped around - the only time the array is cleared
+            std::fill(cluster.visited.begin(), cluster.visited.end(), 0);
+            cluster.generation = 1;
+        }
+        const uint32_t generation = cluster.generation;
+        int *stack = cluster.stack.data();
+        uint32_t *visited = cluster.visited.data();
+
+        const int seed = intDist(rng);
+        const Spin s = spins[seed];
+        const Spin flipped = flippedSpin(s);
+        int top = 0;
+        int clusterSize = 0;
+        stack[top++] = seed;
+        visited[seed] = generation;
+
+        while (top) {
+            const int i = stack[--top];
+            spins[i] = flipped;
+            ++clusterSize;
+            for (const int j : {next[i], previous[i], up[i], down[i]}) {
+                if (visited[j] != generation && spins[j] == s && realDist(rng) < cluster.addProbability) {
+                    visited[j] = generation;
+                    stack[top++] = j;
+                }
+            }
+        }
+        ++cluster.clusters;
+        cluster.flipped += clusterSize;
+        cluster.magnetization -= 2LL * spinValue(s) * clusterSize;
+        return clusterSize;
+    }
+
+    int step(Cluster &cluster,
+             std::vector<int> &spins,
+             const std::vector<int> &next,
+             const std::vector<int> &previous,
+             const std::vector<int> &up,
+             const std::vector<int> &down,
+             pcg64 &rng,
+             std::uniform_real_distribution<double> &realDist,
+             std::uniform_int_distribution<int> &intDist) {
+        return growCluster(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+    }
+
+    int step(Cluster &cluster,
+             std::vector<bool> &spins,
+             const std::vector<int> &next,
+             const std::vector<int> &previous,
+             const std::vector<int> &up,
+             const std::vector<int> &down,
+             pcg64 &rng,
+             std::uniform_real_distribution<double> &realDist,
+             std::uniform_int_distribution<int> &intDist) {
+        return growCluster(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+    }
+
+    template<typename Spin>
+    static void growClusters(Cluster &cluster,
+                             std::vector<Spin> &spins,
+                             const std::vector<int> &next,
+                             const std::vector<int> &previous,
+                             const std::vector<int> &up,
+                             const std::vector<int> &down,
+                             pcg64 &rng,
+                             std::uniform_real_distribution<double> &realDist,
+                             std::uniform_int_distribution<int> &intDist) {
+        for (int k = 0; k < cluster.clustersPerStep; ++k)
+            growCluster(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+    }
+
+    template<typename Spin>
+    static void warmUp(Cluster &cluster,
+                          std::vector<Spin> &spins,
+                          const std::vector<int> &next,
+                          const std::vector<int> &previous,
+                          const std::vector<int> &up,
+                          const std::vector<int> &down,
+                          long long count,
+                          pcg64 &rng,
+                          std::uniform_real_distribution<double> &realDist,
+                          std::uniform_int_distribution<int> &intDist) {
+        /**
+         * Grow clusters until count spins were flipped, then fix the number of clusters per MCS.
+         * (Stopping the production steps at a flipped-spins count would bias the samples towards
+         * states right after large clusters.)
+         */
+        resetStatistics(cluster);
+        long long flipped = 0;
+        do {
+            flipped += growCluster(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+        } while (flipped < count);
+        calibrate(cluster, static_cast<int>(spins.size()));
+    }
+
+    long long monteCarloStep(Cluster &cluster,
+                             std::vector<int> &spins,
+                             const std::vector<int> &next,
+                             const std::vector<int> &previous,
+                             const std::vector<int> &up,
+                             const std::vector<int> &down,
+                             pcg64 &rng,
+                             std::uniform_real_distribution<double> &realDist,
+                             std::uniform_int_distribution<int> &intDist) {
+        growClusters(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+        return cluster.magnetization;
+    }
+
+    long long monteCarloStep(Cluster &cluster,
+                             std::vector<bool> &spins,
+                             const std::vector<int> &next,
+                             const std::vector<int> &previous,
+                             const std::vector<int> &up,
+                             const std::vector<int> &down,
+                             pcg64 &rng,
+                             std::uniform_real_distribution<double> &realDist,
+                             std::uniform_int_distribution<int> &intDist) {
+        growClusters(cluster, spins, next, previous, up, down, rng, realDist, intDist);
+        return cluster.magnetization;
+    }
+
+    void thermalize(Cluster &cluster,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist) {
+        warmUp(cluster, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
+    }
+
+    void thermalize(Cluster &cluster,
+                    std::vector<bool> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist) {
+        warmUp(cluster, spins, next, previous, up, down, warmingTime, rng, realDist, intDist);
+    }
+}
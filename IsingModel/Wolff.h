@@ -0,0 +1,106 @@
+//
+// Created by agent on 17.10.2026.
+//
+
+#ifndef ISING2021_WOLFF_H
+#define ISING2021_WOLFF_H
+
+#include "Utils.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace Wolff {
+    /**
+     * Workspace of the single-cluster algorithm. The stack is allocated once for the whole lattice and
+     * visited sites are marked with the number of the current cluster, so nothing is cleared between clusters.
+     */
+    struct Cluster {
+        std::vector<int> stack;
+        std::vector<uint32_t> visited;
+        uint32_t generation{0};
+        double addProbability{};    // 1 - exp(-2J/T)
+        int clustersPerStep{1};     // fixed during production, so the sampling times do not depend on the state
+        long long clusters{0};      // statistics since the last prepare/resetStatistics
+        long long flipped{0};
+        long long magnetization{0}; // sum of the spins (+-1), updated by every flipped cluster
+    };
+
+    void init(Cluster &cluster, int size);
+    void load(Cluster &cluster, const std::vector<int> &spins);
+    void load(Cluster &cluster, const std::vector<bool> &spins);
+    void setTemperature(Cluster &cluster, const std::array<double, 5> &boltzmannCoeffs);
+    void resetStatistics(Cluster &cluster);
+    void calibrate(Cluster &cluster, int size);
+    double meanClusterSize(const Cluster &cluster);
+
+    int step(Cluster &cluster,
+             std::vector<int> &spins,
+             const std::vector<int> &next,
+             const std::vector<int> &previous,
+             const std::vector<int> &up,
+             const std::vector<int> &down,
+             pcg64 &rng,
+             std::uniform_real_distribution<double> &realDist,
+             std::uniform_int_distribution<int> &intDist);
+
+    int step(Cluster &cluster,
+             std::vector<bool> &spins,
+             const std::vector<int> &next,
+             const std::vector<int> &previous,
+             const std::vector<int> &up,
+             const std::vector<int> &down,
+             pcg64 &rng,
+             std::uniform_real_distribution<double> &realDist,
+             std::uniform_int_distribution<int> &intDist);
+
+    // One MCS = clustersPerStep clusters, on average as many flipped spins as sites in the lattice;
+    // returns the sum of the spins after the step
+    long long monteCarloStep(Cluster &cluster,
+                             std::vector<int> &spins,
+                             const std::vector<int> &next,
+                             const std::vector<int> &previous,
+                             const std::vector<int> &up,
+                             const std::vector<int> &down,
+                             pcg64 &rng,
+                             std::uniform_real_distribution<double> &realDist,
+                             std::uniform_int_distribution<int> &intDist);
+
+    long long monteCarloStep(Cluster &cluster,
+                             std::vector<bool> &spins,
+                             const std::vector<int> &next,
+                             const std::vector<int> &previous,
+                             const std::vector<int> &up,
+                             const std::vector<int> &down,
+                             pcg64 &rng,
+                             std::uniform_real_distribution<double> &realDist,
+                             std::uniform_int_distribution<int> &intDist);
+
+    // warmingTime is given in flipped spins, as the single-spin updates of thermalize;
+    // the mean cluster size measured here sets clustersPerStep
+    void thermalize(Cluster &cluster,
+                    std::vector<int> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist);
+
+    void thermalize(Cluster &cluster,
+                    std::vector<bool> &spins,
+                    const std::vector<int> &next,
+                    const std::vector<int> &previous,
+                    const std::vector<int> &up,
+                    const std::vector<int> &down,
+                    int warmingTime,
+                    pcg64 &rng,
+                    std::uniform_real_distribution<double> &realDist,
+                    std::uniform_int_distribution<int> &intDist);
+}
+
+
+#endif //ISING2021_WOLFF_H
@@ -1,18 +1,104 @@
 #include "Models.h"
+#include "Binary.h"
+#include "Grid.h"
+#include "Pipeline.h"
+#include "Replicas.h"
+#include "Population.h"
+#include "Seeding.h"
+#include "Tempering.h"
+#include "WangLandau.h"
+#include "ThreadPool.h"
 #include "Timer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
 
 
-namespace RandomGenerator {
+static void printUsage() {
+    std::cout<<"Try again. Type in the following order: \n"
+               " 1) L \n"
+               " 2) MCS \n"
+               " 3) warmingTime \n"
+               " 4) takeEvery \n"
+               " 5) Tmin \n"
+               " 6) Tmax \n"
+               " 7) dT \n"
+               " 8) mode \n"
+               " 9) saveData\n"
+               " optional (key=value): \n"
+               "    sweep=rsu|checkerboard|multispin|wolff|sw|nfold\n"
+               "    wolff=<window around Tc>\n"
+               "    nfold=<T below which the n-fold way is used>\n"
+               "    threads=<threads of the parallel engines>\n"
+               "    workers=<temperatures simulated in parallel>\n"
+               "    seed=<master seed>\n"
+               "    boundary=periodic|helical\n"
+               "    spacing=<saved configurations every spacing * tau_int sweeps>\n"
+               "    warmup=fixed|auto, maxwarmup=<steps>\n"
+               "    start=random|anneal, reequilibrate=<updates>\n"
+               "    method=independent|tempering|population, exchange=<sweeps between swaps>\n"
+               "    population=<replicas>, sweeps=<sweeps per temperature>\n"
+               "    method=wanglandau, windows=<walkers>, logf=<final ln f>, flatness=<0..1>, wlmemory=<MB>\n"
+               "    ess=<effective samples>, error=<error bar of <|m|>>, maxmcs=<steps>\n"
+               "    series=0|1\n"
+               "    sinks=<threads>, ring=<slots>, format=txt|bin\n"
+               "    grid=uniform|adaptive, coarse=<coarse dT>, pilot=<pilot MCS>, focus=<MCS factor at Tc>\n"
+               "    replicas=temperatures|<1..64>\n";
 
-    // Seed with a real random value, if available
-    pcg_extras::seed_seq_from<std::random_device> seed_source;
-    // Make a random number engine
-//    pcg32 rng(seed_source);
-    pcg64 rng(seed_source);
+    std::cout<<"Recommended ranges: L>=10, MCS>=1e5, takeEvery>=0, T=[1.0, 5.0], mode=[0,1], saveData=[0,1] \n"
+               "-----------------------------------------------------------------------------------"
+               "\n mode=0 for bool configuration (0,1), mode=1 for standard Ising (-1,1)\n"
+               "saveData=0 for saving only configurations, saveData=1 for all data\n"
+               "sweep=checkerboard updates red/black sublattices with SIMD kernels (mode=1, even L)\n"
+               "sweep=multispin updates 64 bit-packed spins per word (mode=0, even L)\n"
+               "wolff=0.3 uses Wolff cluster updates for |T-Tc|<=0.3 and the chosen sweep elsewhere\n"
+               "sweep=nfold (or nfold=2.0 for T<2.0) draws only the accepted flips (n-fold way, continuous time)\n"
+               "sweep=sw|checkerboard run on threads=<n> threads (default: all cores), checkerboard results\n"
+               "  do not depend on n (counter-based Philox random numbers)\n"
+               "workers=<n> runs the temperatures as independent tasks on n threads (default: all cores divided\n"
+               "  by the threads of sw|checkerboard), the output does not depend on n\n"
+               "boundary=helical joins the rows into one spiral: neighbours (i+-1) mod N, (i+-L) mod N\n"
+               "spacing=2 (saveData=0) writes the MCS/takeEvery+1 configurations of every temperature\n"
+               "  2 tau_int apart, tau_int = max(tau(|m|), tau(e)) from a pilot of 100 tau_int (at most 10000)\n"
+               "  sweeps after the thermalization, refined online (default: every takeEvery)\n"
+               "warmup=auto replaces warmingTime: thermalize until |m| and e stop drifting (at most maxwarmup\n"
+               "  steps, default 100000; Wolff counts single clusters), the steps are printed for every T\n"
+               "ess=<n> and/or error=<e> (saveData=1) replace MCS: the production at every T runs until\n"
+               "  n/(2 tau_int) >= ess and the error bar of <|m|> <= e, at most maxmcs steps (default 10*MCS,\n"
+               "  0 = no cap, only with ess)\n"
+               "series=1 (saveData=1, also method=tempering) appends the (E, M) of every sample to the binary\n"
+               "  *_series.bin sidecar, utils/reweighting.py interpolates <|m|>, chi and U between the temperatures\n"
+               "grid=adaptive runs pilot MCS (default MCS/10) on a coarse grid (default 5*dT, narrowed to keep at\n"
+               "  least 3 temperatures; ranges with fewer than 3 dT temperatures stay uniform), refines the window\n"
+               "  around the chi peak and the steepest Binder slope to dT and gives it up to focus (default 4) times\n"
+               "  the MCS; the grid is written to the *_grid.txt manifest (T, MCS, rows and label per temperature),\n"
+               "  replicas and method=tempering|population|wanglandau only use the refined temperatures\n"
+               "sinks=<n> (saveData=0) formats and writes the configurations on n sink threads fed by a lock-free\n"
+               "  ring of ring slots (default 1024) instead of on the simulation threads, same output; at most ring\n"
+               "  rows of later temperatures wait for their turn, prints the back-pressure\n"
+               "format=bin (saveData=0, independent temperatures) writes *.bin instead of *.txt: a header (L,\n"
+               "  encoding, T grid, steps per T, MCS, warmingTime, takeEvery, seed) and fixed-size records\n"
+               "  (T index, 1 bit per spin), see Binary.h\n"
+               "start=anneal continues every temperature from the final state of the previous (higher) one and\n"
+               "  thermalizes it for reequilibrate updates (default warmingTime/10), the temperatures run in order\n"
+               "method=tempering runs one replica per temperature (threads=<n>) and swaps neighbouring\n"
+               "  temperatures every exchange sweeps; saveData=0 rows are written in temperature blocks at the end\n"
+               "method=population anneals population=<R> replicas (default MCS/takeEvery+1) from T=infinity down\n"
+               "  the temperatures, resampling them and running sweeps=<n> (default 10) sweeps per temperature;\n"
+               "  every temperature writes R configurations, with saveData=1 each one with the averages over the\n"
+               "  population (warmingTime is not used, MCS and takeEvery only set the default R)\n"
+               "method=wanglandau estimates g(E) once with windows=<n> walkers on overlapping energy windows\n"
+               "  (threads=<n>) down to ln f = logf (default 1e-6), then MCS multicanonical sweeps per walker\n"
+               "  collect <|m|>(E), <m^2>(E), <m^4>(E) and configurations; every temperature is reweighted from\n"
+               "  them, saveData=0 draws MCS/takeEvery+1 configurations per T from the stored ones, each stored\n"
+               "  configuration is written at most once per temperature (a temperature stops early when its\n"
+               "  energies are used up), wlmemory=<MB> (default 1024) bounds the stored configurations\n"
+               "seed=<n> makes the run reproducible (default: random, recorded in the *_meta.txt file)\n"
+               "replicas (saveData=0) runs 64 lattices per machine word: one per temperature or <R> lattices at\n"
+               "  every temperature sharing its MCS/takeEvery+1 rows; the rows are written in temperature blocks"<<std::endl;
 }
 
 int main(int argc, char **argv) {
-    double magnetization;
     int takeEvery{};
     int MCS;
     int warmingTime{};
@@ -25,23 +111,8 @@ int main(int argc, char **argv) {
     int mode;
     int saveData;
 
-    if (argc !=10){
-        std::cout<<"Try again. Type in the following order: \n"
-                   " 1) L \n"
-                   " 2) MCS \n"
-                   " 3) warmingTime \n"
-                   " 4) takeEvery \n"
-                   " 5) Tmin \n"
-                   " 6) Tmax \n"
-                   " 7) dT \n"
-                   " 8) mode \n"
-                   " 9) saveData\n";
-
-        std::cout<<"Recommended ranges: L>=10, MCS>=1e5, takeEvery>=0, T=[1.0, 5.0], mode=[0,1], saveData=[0,1] \n"
-                   "-----------------------------------------------------------------------------------"
-                   "\n mode=0 for bool configuration (0,1), mode=1 for standard Ising (-1,1)\n"
-                   "saveData=0 for saving only configurations, saveData=1 for all data"<<std::endl;
-
+    if (argc < 10){
+        printUsage();
         return 0;
     } else {
         std::cout<<"Correct number of values!"<<std::endl;
@@ -57,6 +128,38 @@ int main(int argc, char **argv) {
     std::istringstream (argv[7]) >> dT;
     std::istringstream (argv[8]) >> mode;
     std::istringstream (argv[9]) >> saveData;
+    const auto options = parseOptions(argc, argv, 10);
+    const std::string seedOption = getOption(options, "seed", "");
+    uint64_t seed = 0;
+    if (seedOption.empty()) {
+        seed = Seeding::randomSeed();
+    } else if (!Seeding::parseSeed(seedOption, seed)) {
+        std::cerr << "Invalid seed=" << seedOption << "\n";
+        printUsage();
+        return 1;
+    }
+    auto integerOption = [&](const std::string &key, int defaultValue) {
+        /** Integer key=value option, a value that is not an integer ends the run with the usage message */
+        const std::string text = getOption(options, key, std::to_string(defaultValue));
+        int value = defaultValue;
+        if (!parseInteger(text, value)) {
+            std::cerr << "Invalid " << key << "=" << text << "\n";
+            printUsage();
+            std::exit(1);
+        }
+        return value;
+    };
+    auto doubleOption = [&](const std::string &key, double defaultValue) {
+        /** Real key=value option, a value that is not a number ends the run with the usage message */
+        const std::string text = getOption(options, key, "");
+        double value = defaultValue;
+        if (!text.empty() && !parseDouble(text, value)) {
+            std::cerr << "Invalid " << key << "=" << text << "\n";
+            printUsage();
+            std::exit(1);
+        }
+        return value;
+    };
 
     // Set default values
     if(warmingTime == 0) warmingTime = 20000;
@@ -78,6 +181,8 @@ int main(int argc, char **argv) {
     std::cout<<"dT = "<<dT<<"\n";
     mode? std::cout<<"mode = Standard Ising\n" : std::cout<<"mode = Binary Spins\n";
     saveData? std::cout<<"saveData = save all data\n" : std::cout<<"saveData = save only spins\n";
+    std::cout<<"sweep = "<<getOption(options, "sweep", "rsu")<<"\n";
+    std::cout<<"seed = "<<seed<<"\n";
 
     size = L*L;
 //    Tmin = 1.02;
@@ -86,7 +191,6 @@ int main(int argc, char **argv) {
 //    dT = 0.02;
 
     std::vector<double> Temperatures{};
-    std::array<double, 5> boltzmannCoeff{};
     // define TNN
     std::vector<int> previous(size, 0);
     std::vector<int> next(size, 0);
@@ -98,7 +202,191 @@ int main(int argc, char **argv) {
     std::uniform_int_distribution<int> intDist{0, size-1};
 
     // initialize neighbors
-    initNeighbors(next, previous, up, down, L);
+    const Boundary boundary = parseBoundary(getOption(options, "boundary", "periodic"));
+    if (boundary == Boundary::Helical)
+        initHelicalNeighbors(next, previous, up, down, L);
+    else
+        initNeighbors(next, previous, up, down, L);
+
+    SweepType baseSweep = parseSweepType(getOption(options, "sweep", "rsu"));
+    if (boundary == Boundary::Helical && (baseSweep == SweepType::Checkerboard || baseSweep == SweepType::MultiSpin)) {
+        std::cerr << "Sublattice sweeps are implemented only for periodic boundaries, using random sequential updating\n";
+        baseSweep = SweepType::RandomSequential;
+    }
+    if (baseSweep == SweepType::Checkerboard && (!mode || !Checkerboard::supports(L))) {
+        std::cerr << "Checkerboard sweeps need mode=1 and even L, using random sequential updating\n";
+        baseSweep = SweepType::RandomSequential;
+    }
+    if (baseSweep == SweepType::MultiSpin && (mode || !MultiSpin::supports(L))) {
+        std::cerr << "Multi-spin coding needs mode=0 and even L, using the standard bool updating\n";
+        baseSweep = SweepType::RandomSequential;
+    }
+    const double wolffWindow = doubleOption("wolff", 0.0);
+    const double nfoldBelow = doubleOption("nfold", 0.0);
+    const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int threads = std::max(1, integerOption("threads", hardwareThreads));
+    // only checkerboard and sw split a sweep among threads, by default workers x engine threads fit the cores
+    const int engineThreads = baseSweep == SweepType::Checkerboard ? Checkerboard::teamSize(L, threads)
+                            : baseSweep == SweepType::SwendsenWang ? threads : 1;
+    const int workers = std::max(1, integerOption("workers", std::max(1, hardwareThreads / engineThreads)));
+    const double spacing = doubleOption("spacing", 0.0);
+    const double targetSamples = doubleOption("ess", 0.0);
+    const double targetError = doubleOption("error", 0.0);
+    const int maximumMCS = integerOption("maxmcs", 10 * MCS);
+    if (targetError > 0.0 && maximumMCS <= 0) {
+        // maxmcs=0 lifts the cap, an error bar below the reachable one would never end the run
+        std::cerr << "error=<e> needs a positive maxmcs\n";
+        return 1;
+    }
+    const bool anneal = getOption(options, "start", "random") == "anneal";
+    const bool recordSeries = getOption(options, "series", "0") == "1";
+    const int reequilibrate = integerOption("reequilibrate", std::max(1, warmingTime / 10));
+    const bool automaticWarmup = getOption(options, "warmup", "fixed") == "auto";
+    const int maximumWarmup = integerOption("maxwarmup", 100000);
+    if (maximumWarmup < 1) {
+        std::cerr << "Invalid maxwarmup=" << maximumWarmup << ", the automatic warmup needs at least one step\n";
+        printUsage();
+        return 1;
+    }
+    // the pilots need at least three temperatures to find a window between them
+    const bool adaptiveRequested = getOption(options, "grid", "uniform") == "adaptive";
+    const bool adaptiveGrid = adaptiveRequested && Grid::uniform(Tmax, Tmin, dT).size() >= 3;
+    if (adaptiveRequested && !adaptiveGrid)
+        std::cerr << "grid=adaptive needs at least 3 temperatures of dT between Tmin and Tmax, using the uniform grid\n";
+    const std::string replicaMode = getOption(options, "replicas", "");
+    int replicaCount = 0;   // replicas=<R>: R lattices at every temperature
+    if (!replicaMode.empty() && saveData) {
+        std::cerr << "replicas=" << replicaMode << " writes configurations only, run it with saveData=0\n";
+        return 1;
+    }
+    if (!replicaMode.empty() && replicaMode != "temperatures" &&
+        (!parseInteger(replicaMode, replicaCount) || replicaCount < 1 || replicaCount > Replicas::maxReplicas)) {
+        std::cerr << "Invalid replicas=" << replicaMode << "\n";
+        printUsage();
+        return 1;
+    }
+    const std::string method = getOption(options, "method", "independent");
+    // temperatures as independent tasks, the only runs that follow the per-temperature steps of grid=adaptive
+    const bool independentTasks = replicaMode.empty() && method != "tempering" && method != "population" &&
+                                  method != "wanglandau";
+    if (adaptiveGrid && !independentTasks)
+        std::cerr << "grid=adaptive only refines the temperatures here, every temperature runs MCS steps\n";
+    const bool packedFormat = getOption(options, "format", "txt") == "bin" && !saveData && independentTasks;
+    if (getOption(options, "format", "txt") == "bin" && saveData)
+        std::cerr << "The binary format holds configurations only (saveData=0), writing text\n";
+    else if (getOption(options, "format", "txt") == "bin" && !independentTasks)
+        std::cerr << "The binary format is written for independent temperatures only, writing text\n";
+    const int sinks = std::max(0, integerOption("sinks", 0));
+    const auto ringSlots = static_cast<size_t>(std::max(2, integerOption("ring", 1024)));
+    // production steps of every temperature (MCS everywhere on the uniform grid) and the planned critical window
+    std::vector<int> productionSteps;
+    Grid::Window criticalWindow;
+
+    // fork-join team of every worker (slot 0: the main thread), shared by the engines of its temperatures
+    std::vector<std::shared_ptr<ThreadTeam>> teams(workers + 1);
+    auto workerTeam = [&]() {
+        std::shared_ptr<ThreadTeam> &team = teams[WorkStealingPool::current() + 1];
+        if (!team)
+            team = std::make_shared<ThreadTeam>(engineThreads);
+        return team;
+    };
+
+    auto setupEngine = [&](SweepEngine &engine) {
+        /** Allocate the workspaces of the engines that can be selected for a temperature */
+        engine.type = baseSweep;
+        engine.boundary = boundary;
+        engine.warmup.automatic = automaticWarmup;
+        engine.warmup.maximumSteps = maximumWarmup;
+        if (boundary == Boundary::Helical)
+            Helical::init(engine.helical, L);
+        if (baseSweep == SweepType::Checkerboard)
+            Checkerboard::init(engine.checkerboard, L, workerTeam());
+        if (baseSweep == SweepType::MultiSpin)
+            MultiSpin::init(engine.multiSpin, L);
+        if (baseSweep == SweepType::Wolff || wolffWindow > 0.0)
+            Wolff::init(engine.cluster, size);
+        if (baseSweep == SweepType::SwendsenWang)
+            SwendsenWang::init(engine.swendsenWang, size, workerTeam());
+        if (baseSweep == SweepType::NFold || nfoldBelow > 0.0)
+            NFold::init(engine.nfold, next, previous, up, down);
+    };
+
+    auto startFrom = [&](SweepEngine &engine, size_t k) {
+        /** start=anneal: every temperature after the first continues from the final state of the previous one */
+        engine.warmStart = anneal && k > 0;
+        return engine.warmStart ? reequilibrate : warmingTime;
+    };
+
+    auto runTemperatures = [&](std::ostream &file, auto task) {
+        /** Independent temperatures run in parallel, an annealing chain runs them one after another */
+        if (anneal) {
+            for (size_t k = 0; k < Temperatures.size(); ++k) {
+                task(k, file, std::cout);
+                std::cout << std::flush;
+            }
+            return;
+        }
+        WorkStealingPool pool(workers);
+        runInOrder(pool, Temperatures.size(), file, task);
+    };
+
+    auto makeStage = [&](const std::string &separator, std::ostream &file) {
+        /** sinks=<n>: the saved configurations are formatted and written by n sink threads fed through a lock-free ring */
+        std::unique_ptr<Pipeline::Stage> stage;
+        if (sinks > 0)
+            stage = std::make_unique<Pipeline::Stage>(Temperatures.size(), sinks, ringSlots, separator, file);
+        return stage;
+    };
+    // data stream of the tasks when the sinks write the rows, nothing may reach the file past them
+    std::ostream noRows{nullptr};
+
+    auto makeProducer = [&](Pipeline::Stage *stage, size_t k) {
+        /** Where simulate sends the configurations of the temperature k: sink threads or inline, text or packed */
+        Pipeline::Producer producer = stage ? stage->producer(k) : Pipeline::Producer{};
+        producer.task = k;
+        producer.packed = packedFormat;
+        return producer;
+    };
+
+    auto beginBinary = [&](const std::string &dataFileName) {
+        Binary::Header header{L, mode == 1, MCS, warmingTime, takeEvery, seed, Temperatures, productionSteps};
+        return packedFormat ? Binary::beginRun(dataFileName, header) : 0;
+    };
+
+    auto makeSampler = [&]() {
+        /** Sampling policy of a temperature: spacing of the configurations and the production controller */
+        Autocorrelation::Sampler sampler;
+        sampler.spacing = spacing;
+        sampler.targetSamples = targetSamples;
+        sampler.targetError = targetError;
+        sampler.maximumSteps = maximumMCS;
+        return sampler;
+    };
+
+    auto recordRun = [&](const std::string &dataFileName) {
+        /** Everything needed to reproduce the rows appended to dataFileName */
+        Metadata metadata{{"L", std::to_string(L)},
+                          {"MCS", std::to_string(MCS)},
+                          {"warmingTime", std::to_string(warmingTime)},
+                          {"takeEvery", std::to_string(takeEvery)},
+                          {"Tmin", std::to_string(Tmin)},
+                          {"Tmax", std::to_string(Tmax)},
+                          {"dT", std::to_string(dT)},
+                          {"mode", std::to_string(mode)},
+                          {"saveData", std::to_string(saveData)},
+                          {"seed", std::to_string(seed)},
+                          {"start", anneal ? "anneal" : "random"}};
+        if (anneal)
+            metadata.emplace_back("reequilibrate", std::to_string(reequilibrate));
+        for (const auto &[key, value] : options)
+            if (key != "seed" && key != "start" && key != "reequilibrate")
+                metadata.emplace_back(key, value);
+        metadata.emplace_back("columns", saveData ? "T <|m|> <e> chi Cv U spins..."
+                                                  : packedFormat ? "binary: header, records (T index, bits)" : "T spins...");
+        writeMetadata(dataFileName, metadata);
+        if (adaptiveGrid && independentTasks)
+            Grid::writeManifest(dataFileName, Temperatures, productionSteps, takeEvery, saveData, criticalWindow);
+    };
 
     // fill temperature vector
 //    for (double t=Tmax; t > Tstar+0.3; t -= dT) Temperatures.push_back(t);
@@ -107,23 +395,303 @@ int main(int argc, char **argv) {
 //    for (double t=Tstar+0.3; t > Tstar-0.3; t -= dT) Temperatures.push_back(t);
 //    dT = 0.02;
 //    for (double t=Tstar-0.3; t >= Tmin; t -= dT) Temperatures.push_back(t);
-    for (double t=Tmax; t > Tmin; t -= dT) Temperatures.push_back(t);
+    if (!adaptiveGrid) {
+        Temperatures = Grid::uniform(Tmax, Tmin, dT);
+        productionSteps.assign(Temperatures.size(), MCS);
+    } else {
+        /***************************************************************
+         *  Adaptive grid: short pilot runs on a coarse grid locate the critical window,
+         *  which gets the dT spacing and up to focus times more production steps
+         *  ************************************************************
+         */
+        double coarseStep = doubleOption("coarse", 5 * dT);
+        if (coarseStep <= 0.0) {
+            std::cerr << "Invalid coarse=" << coarseStep << ", the coarse step has to be positive\n";
+            printUsage();
+            return 1;
+        }
+        if (Grid::uniform(Tmax, Tmin, coarseStep).size() < 3) {
+            // a coarse step as wide as the range leaves only Tmax, whose window would be a single temperature
+            coarseStep = std::max(dT, (Tmax - Tmin) / 3.0);
+            std::cerr << "The coarse grid needs at least 3 temperatures, using coarse=" << coarseStep << "\n";
+        }
+        const int pilotSteps = integerOption("pilot", std::max(1000, MCS / 10));
+        const double focus = doubleOption("focus", 4.0);
+        const std::vector<double> coarse = Grid::uniform(Tmax, Tmin, coarseStep);
+        std::vector<Observables::Summary> pilot(coarse.size());
+        {
+            WorkStealingPool pool(workers);
+            for (size_t k = 0; k < coarse.size(); ++k) {
+                pool.submit([&, k] {
+                    const double T = coarse[k];
+                    // ordered start: random starts get stuck in stripes below Tc and fake a Binder slope there
+                    std::vector<int> spins(size, 1);
+                    pcg64 rng = Seeding::stream(seed, L, k, 1);   // replica 1: disjoint from the production streams
+                    auto taskRealDist = realDist;
+                    auto taskChoices = choices;
+                    auto taskIntDist = intDist;
+                    SweepEngine engine;
+                    setupEngine(engine);
+                    // multi-spin coding only exists for bool spins, the pilot runs the integer model
+                    const SweepType pilotSweep = baseSweep == SweepType::MultiSpin ? SweepType::RandomSequential : baseSweep;
+                    engine.type = selectSweep(pilotSweep, T, wolffWindow, nfoldBelow);
+                    engine.warmStart = true;
+                    Observables::Accumulator observables;
+                    Autocorrelation::Sampler sampler;
+                    auto boltzmannCoeff = MetropolisRSU::calculateBoltzmannCoeff(T);
+                    MetropolisRSU::simulate(size, spins, next, previous, up, down, pilotSteps, warmingTime, 1,
+                                            taskRealDist, boltzmannCoeff, taskChoices, taskIntDist, rng,
+                                            engine, observables, sampler);
+                    pilot[k] = Observables::summarize(observables, T, size);
+                });
+            }
+            pool.wait();
+        }
+        criticalWindow = Grid::criticalWindow(coarse, pilot);
+        Temperatures = Grid::refine(coarse, criticalWindow, dT);
+        productionSteps = Grid::allocate(Temperatures, criticalWindow, MCS, takeEvery, focus);
+        std::cout<<"critical window T="<<criticalWindow.center - criticalWindow.halfWidth<<" ... "
+                 <<criticalWindow.center + criticalWindow.halfWidth<<", "<<Temperatures.size()<<" temperatures\n";
+    }
     std::string fileName;
+    // final state of the previous temperature for start=anneal
+    std::vector<bool> annealedBool(size, false);
+    std::vector<int> annealedInt(size, 0);
+    // (E, M) of every sample for the offline reweighting, series=1
+    std::vector<std::vector<int32_t>> series(Temperatures.size());
 
+    auto makeObservables = [&]() {
+        Observables::Accumulator observables;
+        observables.seriesSize = recordSeries ? size : 0;
+        return observables;
+    };
 
-    if (!mode) {
+    auto saveSeries = [&](const std::string &dataFileName) {
+        if (recordSeries)
+            Observables::writeSeries(seriesFileName(dataFileName), L, takeEvery, Temperatures, series);
+    };
+
+    if (!replicaMode.empty()) {
         /***************************************************************
-         *  Bool Spin simulation
+         *  Replica-parallel multi-spin coding: bit k of every word is replica k
+         *  ************************************************************
+         */
+        fileName = generateFileName(mode ? "Data" : "DataBool", L, MCS, warmingTime, saveData, 0.0, ".txt");
+        std::string separator = " ";
+        std::ofstream file{fileName, std::ios::app}; //appending mode
+        if (!file)
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
+
+        Replicas::Lattice lattice;
+        Timer timer;
+        if (replicaMode == "temperatures") {
+            for (size_t first = 0; first < Temperatures.size(); first += Replicas::maxReplicas) {
+                size_t last = std::min(first + Replicas::maxReplicas, Temperatures.size());
+                std::vector<double> lanes(Temperatures.begin() + first, Temperatures.begin() + last);
+                pcg64 rng = Seeding::stream(seed, L, first);
+                const std::vector<int> rows(lanes.size(), MCS / takeEvery + 1);
+                Replicas::simulate(lattice, next, previous, up, down, rng, lanes,
+                                   rows, warmingTime, takeEvery, mode, file, separator);
+                std::cout<<"T="<<lanes.front()<<" ... "<<lanes.back()<<"\n";
+            }
+        } else {
+            for (size_t k = 0; k < Temperatures.size(); ++k) {
+                const double T = Temperatures[k];
+                std::vector<double> lanes(replicaCount, T);
+                // the MCS/takeEvery+1 rows of the temperature split among the replicas
+                std::vector<int> rows(replicaCount, (MCS / takeEvery + 1) / replicaCount);
+                for (int r = 0; r < (MCS / takeEvery + 1) % replicaCount; ++r)
+                    ++rows[r];
+                pcg64 rng = Seeding::stream(seed, L, k);
+                Replicas::simulate(lattice, next, previous, up, down, rng, lanes,
+                                   rows, warmingTime, takeEvery, mode, file, separator);
+                std::cout<<"T="<<T<<"\n";
+            }
+        }
+        file.close();
+        std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
+        return 0;
+    }
+
+    if (method == "tempering") {
+        /***************************************************************
+         *  Parallel tempering: one replica per temperature, neighbour swaps between the sweeps
+         *  ************************************************************
+         */
+        if (baseSweep != SweepType::RandomSequential || wolffWindow > 0.0 || nfoldBelow > 0.0)
+            std::cerr << "Parallel tempering uses the single-spin updates, sweep/wolff/nfold are ignored\n";
+        const int exchangeEvery = std::max(1, integerOption("exchange", 1));
+        fileName = generateFileName(mode ? "Data" : "DataBool", L, MCS, warmingTime, saveData, 0.0, ".txt");
+        std::string separator = " ";
+        std::ofstream file{fileName, std::ios::app}; //appending mode
+        if (!file)
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
+
+        std::vector<Observables::Accumulator> observables(Temperatures.size(), makeObservables());
+        Tempering::Statistics statistics;
+        Timer timer;
+        Tempering::simulate(Temperatures, L, next, previous, up, down, boundary, seed,
+                            MCS, warmingTime, takeEvery, exchangeEvery, threads, mode == 1, saveData == 1,
+                            file, separator, observables, statistics);
+        for (size_t k = 0; k < Temperatures.size(); ++k) {
+            const auto summary = Observables::summarize(observables[k], Temperatures[k], size);
+            std::cout<<"T="<<Temperatures[k]<<" M="<<summary.absMagnetization<<" chi="<<summary.susceptibility
+                     <<" Cv="<<summary.specificHeat<<" U="<<summary.binder;
+            if (k + 1 < Temperatures.size())
+                std::cout<<" swap="<<Tempering::acceptance(statistics, k);
+            std::cout<<"\n";
+            series[k] = std::move(observables[k].series);
+        }
+        saveSeries(fileName);
+        std::cout<<"round trips = "<<statistics.roundTrips<<", mean round trip = "
+                 <<Tempering::meanRoundTrip(statistics)<<" sweeps\n";
+        file.close();
+        std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
+        return 0;
+    }
+
+    if (method == "population") {
+        /***************************************************************
+         *  Population annealing: R replicas annealed down the temperatures together
          *  ************************************************************
          */
+        if (baseSweep != SweepType::RandomSequential || wolffWindow > 0.0 || nfoldBelow > 0.0)
+            std::cerr << "Population annealing uses the single-spin updates, sweep/wolff/nfold are ignored\n";
+        // every temperature writes one row per replica, MCS/takeEvery+1 matches the rows of the other methods
+        const int rows = MCS / takeEvery + 1;
+        const int replicas = std::max(1, integerOption("population", rows));
+        if (replicas != rows)
+            std::cerr << "population=" << replicas << " writes " << replicas << " rows per temperature instead of MCS/takeEvery+1="
+                      << rows << "\n";
+        const int sweeps = std::max(1, integerOption("sweeps", 10));
+        fileName = generateFileName(mode ? "Data" : "DataBool", L, MCS, warmingTime, saveData, 0.0, ".txt");
+        std::string separator = " ";
+        std::ofstream file{fileName, std::ios::app}; //appending mode
+        if (!file)
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
 
-        std::vector<bool> spins(size, false); // for bool {0,1} configs
+        std::vector<Population::Step> steps;
+        Timer timer;
+        Population::simulate(Temperatures, L, next, previous, up, down, boundary, seed,
+                             replicas, sweeps, threads, mode == 1, saveData == 1, file, separator, steps);
+        for (size_t k = 0; k < Temperatures.size(); ++k) {
+            const auto &step = steps[k];
+            std::cout<<"T="<<Temperatures[k]<<" M="<<step.summary.absMagnetization<<" chi="<<step.summary.susceptibility
+                     <<" Cv="<<step.summary.specificHeat<<" U="<<step.summary.binder<<" f="<<step.freeEnergy
+                     <<" families="<<step.families<<" inserted="<<step.intermediate<<"\n";
+        }
+        file.close();
+        std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
+        return 0;
+    }
 
-        fileName = generateFileName("DataBool", L, MCS, warmingTime, saveData, 0.0, ".txt");
+    if (method == "wanglandau") {
+        /***************************************************************
+         *  Wang-Landau: one density of states, every temperature by reweighting
+         *  ************************************************************
+         */
+        if (baseSweep != SweepType::RandomSequential || wolffWindow > 0.0 || nfoldBelow > 0.0)
+            std::cerr << "Wang-Landau uses its own single-spin walkers, sweep/wolff/nfold are ignored\n";
+        WangLandau::Settings settings;
+        settings.walkers = std::max(1, integerOption("windows", threads));
+        settings.threads = threads;
+        settings.finalLogF = doubleOption("logf", 1e-6);
+        settings.flatness = doubleOption("flatness", 0.8);
+        settings.productionSweeps = MCS;
+        // a single energy can carry a whole temperature, its reservoir holds the MCS/takeEvery+1 rows of saveData=0
+        if (!saveData)
+            settings.reservoir = std::max(settings.reservoir, MCS / takeEvery + 1);
+        settings.reservoirMegabytes = doubleOption("wlmemory", 1024.0);
+        fileName = generateFileName(mode ? "Data" : "DataBool", L, MCS, warmingTime, saveData, 0.0, ".txt");
         std::string separator = " ";
         std::ofstream file{fileName, std::ios::app}; //appending mode
         if (!file)
             std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
+
+        WangLandau::DensityOfStates states;
+        Timer timer;
+        WangLandau::estimate(states, L, next, previous, up, down, seed, settings);
+        std::cout<<"g(E) estimated with "<<states.stages.size()<<" walkers in "<<timer.elapsed()<<" seconds\n";
+        if (states.reservoir < settings.reservoir)
+            std::cerr << "wlmemory=" << settings.reservoirMegabytes << " MB keeps " << states.reservoir
+                      << " configurations per energy instead of " << settings.reservoir << "\n";
+
+        pcg64 rng = Seeding::stream(seed, L, states.stages.size());
+        std::vector<int> spins(size);
+        auto load = [&](const std::vector<bool> &configuration) {
+            for (int i = 0; i < size; ++i)
+                spins[i] = configuration[i] ? 1 : -1;
+        };
+        auto shortage = [&](double T) {
+            /** Why the energy that ended the draws of T had no configuration left */
+            const int b = states.exhausted;
+            std::ostringstream reason;
+            reason << "energy " << states.minimumEnergy + 4LL * b << " of T=" << T << " holds "
+                   << states.samples[b].size() << " configurations, ";
+            if (static_cast<int>(states.samples[b].size()) < states.reservoir)
+                reason << "all its production visits (raise MCS)";
+            else
+                reason << "the reservoir per energy (raise wlmemory)";
+            return reason.str();
+        };
+        for (const double T : Temperatures) {
+            // the configurations are unique within a temperature, every temperature draws from all of them
+            WangLandau::rewind(states);
+            const auto summary = WangLandau::canonical(states, T);
+            std::cout<<"T="<<T<<" M="<<summary.absMagnetization<<" e="<<summary.energy<<" chi="<<summary.susceptibility
+                     <<" Cv="<<summary.specificHeat<<" U="<<summary.binder<<"\n";
+            if (saveData) {
+                const auto *configuration = WangLandau::sample(states, T, rng);
+                if (!configuration) {
+                    std::cerr << "No Wang-Landau configuration stored, raise MCS\n";
+                    continue;
+                }
+                if (mode) {
+                    load(*configuration);
+                    writeData(spins, summary, T, file, separator);
+                } else {
+                    BoolSpinConfigurations::writeData(*configuration, summary, T, file, separator);
+                }
+                continue;
+            }
+            int written = 0;
+            for (; written <= MCS / takeEvery; ++written) {
+                const auto *configuration = WangLandau::sample(states, T, rng);
+                if (!configuration)
+                    break;
+                if (mode) {
+                    load(*configuration);
+                    writeConfigurations(spins, T, file, separator);
+                } else {
+                    BoolSpinConfigurations::writeConfigurations(*configuration, T, file, separator);
+                }
+            }
+            if (written <= MCS / takeEvery && states.exhausted < 0)
+                std::cerr << "No Wang-Landau configuration stored, raise MCS\n";
+            else if (written <= MCS / takeEvery)
+                std::cerr << written << " of " << MCS / takeEvery + 1 << " rows written: " << shortage(T) << "\n";
+        }
+        file.close();
+        std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
+        return 0;
+    }
+
+    if (!mode) {
+        /***************************************************************
+         *  Bool Spin simulation
+         *  ************************************************************
+         */
+
+        fileName = generateFileName("DataBool", L, MCS, warmingTime, saveData, 0.0, packedFormat ? ".bin" : ".txt");
+        std::string separator = " ";
+        std::ofstream file{fileName, packedFormat ? std::ios::app | std::ios::binary : std::ios::app}; //appending mode
+        if (!file)
+            std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
 
         if (saveData) {  //
             /*************************************************************************************
@@ -131,22 +699,44 @@ int main(int argc, char **argv) {
              *  **********************************************************************************
              */
             Timer timer;
-            for (const auto &T : Temperatures) {
-                boltzmannCoeff = BoolSpinConfigurations::calculateBoltzmannCoeff(T);
-                magnetization = BoolSpinConfigurations::simulate(spins, next, previous, up, down,
-                                                                 RandomGenerator::rng,
-                                                                 realDist,
-                                                                 choices,
-                                                                 intDist,
-                                                                 boltzmannCoeff,
-                                                                 size,
-                                                                 MCS,
-                                                                 warmingTime,
-                                                                 takeEvery);
-                BoolSpinConfigurations::writeData(spins, magnetization, T, file, separator);
-                std::cout<<"T="<<T<<" M="<<magnetization<<"\n";
-            }
+            runTemperatures(file, [&](size_t k, std::ostream &out, std::ostream &log) {
+                const double T = Temperatures[k];
+                std::vector<bool> spins = anneal ? annealedBool : std::vector<bool>(size, false); // for bool {0,1} configs
+                pcg64 rng = Seeding::stream(seed, L, k);
+                auto taskRealDist = realDist;
+                auto taskChoices = choices;
+                auto taskIntDist = intDist;
+                SweepEngine engine;
+                setupEngine(engine);
+                engine.type = selectSweep(baseSweep, T, wolffWindow, nfoldBelow);
+                const int warming = startFrom(engine, k);
+                Observables::Accumulator observables = makeObservables();
+                Autocorrelation::Sampler sampler = makeSampler();
+
+                auto boltzmannCoeff = BoolSpinConfigurations::calculateBoltzmannCoeff(T);
+                BoolSpinConfigurations::simulate(spins, next, previous, up, down,
+                                                 rng,
+                                                 taskRealDist,
+                                                 taskChoices,
+                                                 taskIntDist,
+                                                 boltzmannCoeff,
+                                                 size,
+                                                 productionSteps[k],
+                                                 warming,
+                                                 takeEvery,
+                                                 engine,
+                                                 observables,
+                                                 sampler);
+                const auto summary = Observables::summarize(observables, T, size);
+                BoolSpinConfigurations::writeData(spins, summary, T, out, separator);
+                if (anneal)
+                    annealedBool = spins;
+                series[k] = std::move(observables.series);
+                log<<"T="<<T<<" M="<<summary.absMagnetization<<" chi="<<summary.susceptibility<<" Cv="<<summary.specificHeat
+                   <<" U="<<summary.binder<<samplingSummary(sampler)<<sweepSummary(engine)<<"\n";
+            });
             file.close();
+            saveSeries(fileName);
             std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
         }
         else {
@@ -155,25 +745,51 @@ int main(int argc, char **argv) {
              *  ********************************************
              */
             Timer timer;
-            for (const auto &T : Temperatures) {
-                boltzmannCoeff = BoolSpinConfigurations::calculateBoltzmannCoeff(T);
+            auto stage = makeStage(separator, file);
+            const uint64_t headerOffset = beginBinary(fileName);
+            runTemperatures(stage ? noRows : file, [&](size_t k, std::ostream &out, std::ostream &log) {
+                const double T = Temperatures[k];
+                std::vector<bool> spins = anneal ? annealedBool : std::vector<bool>(size, false); // for bool {0,1} configs
+                pcg64 rng = Seeding::stream(seed, L, k);
+                auto taskRealDist = realDist;
+                auto taskChoices = choices;
+                auto taskIntDist = intDist;
+                SweepEngine engine;
+                setupEngine(engine);
+                engine.type = selectSweep(baseSweep, T, wolffWindow, nfoldBelow);
+                const int warming = startFrom(engine, k);
+                engine.output = makeProducer(stage.get(), k);
+                Autocorrelation::Sampler sampler = makeSampler();
+
+                auto boltzmannCoeff = BoolSpinConfigurations::calculateBoltzmannCoeff(T);
                 BoolSpinConfigurations::simulate(spins, next, previous, up, down,
-                                                                 RandomGenerator::rng,
-                                                                 realDist,
-                                                                 choices,
-                                                                 intDist,
-                                                                 boltzmannCoeff,
-                                                                 size,
-                                                                 MCS,
-                                                                 warmingTime,
-                                                                 takeEvery,
-                                                                 T,
-                                                                 file,
-                                                                 separator);
-//                BoolSpinConfigurations::writeConfigurations(spins, T, file, separator);
-                std::cout<<"T="<<T<<"\n";
+                                                 rng,
+                                                 taskRealDist,
+                                                 taskChoices,
+                                                 taskIntDist,
+                                                 boltzmannCoeff,
+                                                 size,
+                                                 productionSteps[k],
+                                                 warming,
+                                                 takeEvery,
+                                                 T,
+                                                 out,
+                                                 separator,
+                                                 engine,
+                                                 sampler);
+                if (stage)
+                    stage->finish(engine.output);
+                if (anneal)
+                    annealedBool = spins;
+                log<<"T="<<T<<samplingSummary(sampler)<<sweepSummary(engine)<<"\n";
+            });
+            if (stage) {
+                stage->close();
+                std::cout<<Pipeline::summary(stage->metrics())<<"\n";
             }
             file.close();
+            if (packedFormat)
+                Binary::finishRun(fileName, headerOffset);
             std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
         }
     }
@@ -182,13 +798,13 @@ int main(int argc, char **argv) {
           *  save magnetization and configurations for given temperature in IntegerSpin {-1,1} simulation
           *  **********************************************************************************
         */
-        std::vector<int> spins(size, 0); // for integer {-1,1} configs
 
-        fileName = generateFileName("Data", L, MCS, warmingTime, saveData, 0.0, ".txt");
+        fileName = generateFileName("Data", L, MCS, warmingTime, saveData, 0.0, packedFormat ? ".bin" : ".txt");
         std::string separator = " ";
-        std::ofstream file{fileName, std::ios::app}; //appending mode
+        std::ofstream file{fileName, packedFormat ? std::ios::app | std::ios::binary : std::ios::app}; //appending mode
         if (!file)
             std::cerr << "Uh oh, The file could not be opened for writing!\n";
+        recordRun(fileName);
 
         if (saveData) { // save magnetization and configurations for given temperature
             /*************************************************************************************
@@ -196,23 +812,45 @@ int main(int argc, char **argv) {
              *  **********************************************************************************
              */
             Timer timer;
-            for (const auto &T : Temperatures) {
-                boltzmannCoeff = MetropolisRSU::calculateBoltzmannCoeff(T);
-                magnetization = MetropolisRSU::simulate(size,
-                                                        spins,next, previous, up, down,
-                                                        MCS,
-                                                        warmingTime,
-                                                        takeEvery,
-                                                        realDist,
-                                                        boltzmannCoeff,
-                                                        choices,
-                                                        intDist,
-                                                        RandomGenerator::rng
-                                                        );
-                writeData(spins, magnetization, T, file, separator);
-                std::cout<<"T="<<T<<" M="<<magnetization<<"\n";
-            }
+            runTemperatures(file, [&](size_t k, std::ostream &out, std::ostream &log) {
+                const double T = Temperatures[k];
+                std::vector<int> spins = anneal ? annealedInt : std::vector<int>(size, 0); // for integer {-1,1} configs
+                pcg64 rng = Seeding::stream(seed, L, k);
+                auto taskRealDist = realDist;
+                auto taskChoices = choices;
+                auto taskIntDist = intDist;
+                SweepEngine engine;
+                setupEngine(engine);
+                engine.type = selectSweep(baseSweep, T, wolffWindow, nfoldBelow);
+                const int warming = startFrom(engine, k);
+                Observables::Accumulator observables = makeObservables();
+                Autocorrelation::Sampler sampler = makeSampler();
+
+                auto boltzmannCoeff = MetropolisRSU::calculateBoltzmannCoeff(T);
+                MetropolisRSU::simulate(size,
+                                        spins,next, previous, up, down,
+                                        productionSteps[k],
+                                        warming,
+                                        takeEvery,
+                                        taskRealDist,
+                                        boltzmannCoeff,
+                                        taskChoices,
+                                        taskIntDist,
+                                        rng,
+                                        engine,
+                                        observables,
+                                        sampler
+                                        );
+                const auto summary = Observables::summarize(observables, T, size);
+                writeData(spins, summary, T, out, separator);
+                if (anneal)
+                    annealedInt = spins;
+                series[k] = std::move(observables.series);
+                log<<"T="<<T<<" M="<<summary.absMagnetization<<" chi="<<summary.susceptibility<<" Cv="<<summary.specificHeat
+                   <<" U="<<summary.binder<<samplingSummary(sampler)<<sweepSummary(engine)<<"\n";
+            });
             file.close();
+            saveSeries(fileName);
             std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
         }
         else { // save only spin configurations // --> for my master thesis
@@ -221,26 +859,52 @@ int main(int argc, char **argv) {
              *  ********************************************
              */
             Timer timer;
-            for (const auto &T : Temperatures) {
-                boltzmannCoeff = MetropolisRSU::calculateBoltzmannCoeff(T);
+            auto stage = makeStage(separator, file);
+            const uint64_t headerOffset = beginBinary(fileName);
+            runTemperatures(stage ? noRows : file, [&](size_t k, std::ostream &out, std::ostream &log) {
+                const double T = Temperatures[k];
+                std::vector<int> spins = anneal ? annealedInt : std::vector<int>(size, 0); // for integer {-1,1} configs
+                pcg64 rng = Seeding::stream(seed, L, k);
+                auto taskRealDist = realDist;
+                auto taskChoices = choices;
+                auto taskIntDist = intDist;
+                SweepEngine engine;
+                setupEngine(engine);
+                engine.type = selectSweep(baseSweep, T, wolffWindow, nfoldBelow);
+                const int warming = startFrom(engine, k);
+                engine.output = makeProducer(stage.get(), k);
+                Autocorrelation::Sampler sampler = makeSampler();
+
+                auto boltzmannCoeff = MetropolisRSU::calculateBoltzmannCoeff(T);
                 MetropolisRSU::simulate(size,
                                         spins,next, previous, up, down,
-                                        MCS,
-                                        warmingTime,
+                                        productionSteps[k],
+                                        warming,
                                         takeEvery,
                                         T,
-                                        realDist,
+                                        taskRealDist,
                                         boltzmannCoeff,
-                                        choices,
-                                        intDist,
-                                        RandomGenerator::rng,
-                                        file,
-                                        separator
+                                        taskChoices,
+                                        taskIntDist,
+                                        rng,
+                                        out,
+                                        separator,
+                                        engine,
+                                        sampler
                                         );
-//                writeConfigurations(spins, T, file, separator);
-                std::cout<<"T="<<T<<"\n";
+                if (stage)
+                    stage->finish(engine.output);
+                if (anneal)
+                    annealedInt = spins;
+                log<<"T="<<T<<samplingSummary(sampler)<<sweepSummary(engine)<<"\n";
+            });
+            if (stage) {
+                stage->close();
+                std::cout<<Pipeline::summary(stage->metrics())<<"\n";
             }
             file.close();
+            if (packedFormat)
+                Binary::finishRun(fileName, headerOffset);
             std::cout<<"Simulations done! Time elapsed: " << timer.elapsed() << " seconds\n";
         }
     }
@@ -11,6 +11,8 @@ from tensorflow.keras.regularizers import l2
 from tensorflow.keras.utils import to_categorical
 
 
+import mmap
+import os
 import numpy as np
 import pandas as pd
 import glob
@@ -63,6 +65,95 @@ def base_prepare(df, exportLabels = False, normalize_data = False, select_val_se
     return X, Y
 
 
+def labels_from_manifest(manifest_path, index_="L_", save=True):
+    """
+    Labels of the data file rows from the *_grid.txt manifest of grid=adaptive:
+    every temperature contributes `rows` rows with its label (1 if T > 2.26), in the order of the data file.
+    Only the last block (the last run appended to the data file) is used.
+    """
+    blocks, block = [], []
+    with open(manifest_path) as manifest:
+        for line in manifest:
+            if line.startswith("# window"):
+                block = []
+                blocks.append(block)
+            elif not line.startswith("#") and line.strip():
+                index, T, mcs, rows, label = line.split()
+                block.append((float(T), int(rows), int(label)))
+
+    temp_class = np.concatenate([np.full(rows, label) for _, rows, label in blocks[-1]])
+    Y = to_categorical(temp_class, num_classes=2).astype(np.int8)
+    if save:
+        np.save(f"labels/labels_{index_}", Y)
+    return Y
+
+
+BINARY_HEADER = np.dtype([("magic", "S8"), ("header_size", "<u4"), ("version", "<u4"), ("L", "<i4"),
+                          ("encoding", "<i4"), ("MCS", "<i4"), ("warming_time", "<i4"), ("take_every", "<i4"),
+                          ("temperatures", "<u4"), ("seed", "<u8"), ("records", "<u8"), ("record_size", "<u4"),
+                          ("reserved", "<u4")])
+
+
+def read_binary_runs(path):
+    """
+    Headers of the runs in a format=bin file (layout in IsingModel/Binary.h).
+    Every run is a dict with the header fields, the temperature grid "T", the production "steps" of every
+    temperature and the byte "offset" of its records.
+    A run that did not finish (records 0) gets the whole records up to the next header or the end of the file.
+    """
+    runs, offset = [], 0
+    size = os.path.getsize(path)
+    with open(path, "rb") as file, mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as data:
+        while offset < size:
+            header = np.frombuffer(data, dtype=BINARY_HEADER, count=1, offset=offset).copy()[0]
+            if header["magic"] != b"ISINGCF1":
+                raise ValueError(f"{path}: no header at byte {offset}")
+            run = {name: header[name].item() for name in BINARY_HEADER.names if name not in ("magic", "reserved")}
+            count = run["temperatures"]
+            start = offset + BINARY_HEADER.itemsize
+            run["T"] = np.frombuffer(data, dtype="<f8", count=count, offset=start).copy()
+            if run["version"] >= 2:
+                run["steps"] = np.frombuffer(data, dtype="<i4", count=count, offset=start + 8 * count).copy()
+            else:
+                run["steps"] = np.full(count, run["MCS"], dtype=np.int32)
+            run["offset"] = offset + run["header_size"]
+            if run["records"] == 0:
+                following = data.find(b"ISINGCF1", run["offset"])
+                end = size if following < 0 else following
+                run["records"] = (end - run["offset"]) // run["record_size"]
+                offset = end
+            else:
+                offset = run["offset"] + run["records"] * run["record_size"]
+            runs.append(run)
+    return runs
+
+
+def read_binary_configurations(path, run=-1, start=0, stop=None):
+    """
+    Records start..stop of one run of a format=bin file without parsing the rest:
+    returns the temperature of every record and the spins (records x L*L) in the encoding of the run (-1/1 or 0/1).
+    The file is memory-mapped, so any slice costs only its own records.
+    """
+    header = read_binary_runs(path)[run]
+    size = header["L"] ** 2
+    records = np.memmap(path, dtype=np.uint8, mode="r", offset=header["offset"],
+                        shape=(header["records"], header["record_size"]))[start:stop]
+    indices = records[:, :4].copy().view("<u4").ravel()
+    spins = np.unpackbits(records[:, 4:], axis=1, count=size, bitorder="little").astype(np.int8)
+    if header["encoding"] == 1:
+        spins = 2 * spins - 1
+    return header["T"][indices], spins
+
+
+def binary_to_dataframe(path, run=-1):
+    """Same layout as the text files (column 0: Temperature, then the spins), e.g. for base_prepare"""
+    temperatures, spins = read_binary_configurations(path, run)
+    df = pd.DataFrame(spins)
+    df.columns = range(1, spins.shape[1] + 1)
+    df.insert(0, "Temperature", temperatures)
+    return df
+
+
 def fit_linregress(x, y, return_stats=False, expand=True, x_factor=0.9, y_factor=1.1):
     """
     fit linear regression using scipy stats
@@ -0,0 +1,169 @@
+import argparse
+
+import numpy as np
+
+
+MAGIC = b"ISINGTS1"
+
+
+def read_series(path):
+    """
+    Read the *_series.bin sidecar written by series=1.
+    Returns a list of runs (the file is appended to by every run), each a dict with
+    L, take_every and a list of (T, E, M) with E, M the int64 arrays of total energy and magnetization
+    """
+    raw = open(path, "rb").read()
+    runs, offset = [], 0
+    while offset < len(raw):
+        if raw[offset:offset + 8] != MAGIC:
+            raise ValueError(f"{path}: no series header at byte {offset}")
+        L, take_every, count = np.frombuffer(raw, dtype="=i4", count=3, offset=offset + 8)
+        offset += 20
+        temperatures = []
+        for _ in range(count):
+            T = float(np.frombuffer(raw, dtype="=f8", count=1, offset=offset)[0])
+            samples = int(np.frombuffer(raw, dtype="=i8", count=1, offset=offset + 8)[0])
+            offset += 16
+            pairs = np.frombuffer(raw, dtype="=i4", count=2 * samples, offset=offset).reshape(-1, 2).astype(np.int64)
+            offset += 8 * samples
+            temperatures.append((T, pairs[:, 0], pairs[:, 1]))
+        runs.append({"L": int(L), "take_every": int(take_every), "temperatures": temperatures})
+    return runs
+
+
+def logsumexp(x, axis=None):
+    top = np.max(x, axis=axis, keepdims=True)
+    return np.squeeze(top, axis=axis) + np.log(np.sum(np.exp(x - top), axis=axis))
+
+
+def moments(log_weights, E, M, T, N):
+    """
+    Canonical observables from the log-weights of the samples,
+    with the same estimators as Observables::summarize (chi from the variance of |m|)
+    """
+    w = np.exp(log_weights - log_weights.max())
+    w /= w.sum()
+    m, e = M / N, E / N
+    absm = np.sum(w * np.abs(m))
+    m2 = np.sum(w * m ** 2)
+    m4 = np.sum(w * m ** 4)
+    e1 = np.sum(w * e)
+    e2 = np.sum(w * e ** 2)
+    return {"<|m|>": absm,
+            "<e>": e1,
+            "chi": N * (m2 - absm ** 2) / T,
+            "Cv": N * (e2 - e1 ** 2) / T ** 2,
+            "U": 1 - m4 / (3 * m2 ** 2) if m2 > 0 else 0.0}
+
+
+def single_histogram(T0, E, M, T, N):
+    """Ferrenberg-Swendsen: samples of one temperature T0 reweighted by exp(-(1/T - 1/T0) E)"""
+    return moments(-(1 / T - 1 / T0) * E, E, M, T, N)
+
+
+def wham(betas, energies, tolerance=1e-10, max_iterations=100000, log_Z=None):
+    """
+    Multi-histogram (Ferrenberg-Swendsen / WHAM) free energies ln Z_k of all simulated temperatures.
+    The equations only depend on the energies, so they are iterated on the distinct energies with their counts.
+    ln Z of the first temperature is fixed to 0.
+    """
+    counts = np.array([len(E) for E in energies], dtype=float)
+    levels, pooled = np.unique(np.concatenate(energies), return_counts=True)
+    log_Z = np.zeros(len(betas)) if log_Z is None else log_Z.copy()
+    exponents = -np.outer(betas, levels)                       # -beta_k E
+    for _ in range(max_iterations):
+        # ln of sum_j N_j exp(-beta_j E) / Z_j for every energy
+        log_denominator = logsumexp(np.log(counts)[:, None] + exponents - log_Z[:, None], axis=0)
+        updated = logsumexp(np.log(pooled)[None, :] + exponents - log_denominator[None, :], axis=1)
+        updated -= updated[0]
+        converged = np.max(np.abs(updated - log_Z)) < tolerance
+        log_Z = updated
+        if converged:
+            break
+    return log_Z
+
+
+def wham_reweight(betas, energies, magnetizations, log_Z, T, N):
+    """Observables at T from all the samples, weighted by exp(-E/T) / sum_j N_j exp(-beta_j E) / Z_j"""
+    counts = np.array([len(E) for E in energies], dtype=float)
+    E = np.concatenate(energies)
+    M = np.concatenate(magnetizations)
+    log_denominator = logsumexp(np.log(counts)[:, None] - np.outer(betas, E) - log_Z[:, None], axis=0)
+    return moments(-E / T - log_denominator, E, M, T, N)
+
+
+def jackknife(estimate, blocks):
+    """
+    Leave-one-block-out estimates: estimate(b) drops the block b of every series (b = None keeps all).
+    Returns the full estimate and the jackknife error of every observable
+    """
+    full = estimate(None)
+    partial = [estimate(b) for b in range(blocks)]
+    errors = {key: np.sqrt((blocks - 1) / blocks * np.sum((np.array([p[key] for p in partial])
+                                                           - np.mean([p[key] for p in partial])) ** 2))
+              for key in full}
+    return full, errors
+
+
+def drop_block(x, b, blocks):
+    if b is None:
+        return x
+    edges = np.linspace(0, len(x), blocks + 1).astype(int)
+    return np.concatenate([x[:edges[b]], x[edges[b + 1]:]])
+
+
+def reweight(path, targets, method="wham", blocks=16, window=None):
+    """
+    <|m|>, <e>, chi, Cv and U with jackknife error bars at the target temperatures.
+    method="single" reweights the nearest simulated temperature, method="wham" combines all of them
+    (only those within window of the targets when it is given).
+    Samples of a series are assumed to be nearly independent (takeEvery of the order of tau_int).
+    """
+    runs = read_series(path)
+    L = runs[0]["L"]
+    N = L * L
+    data = sorted((T, E, M) for run in runs for (T, E, M) in run["temperatures"] if len(E) >= blocks)
+    if window is not None:
+        data = [d for d in data if min(targets) - window <= d[0] <= max(targets) + window]
+    temperatures = np.array([d[0] for d in data])
+    betas = 1 / temperatures
+    rows = []
+
+    if method == "single":
+        for T in targets:
+            T0, E, M = data[int(np.argmin(np.abs(temperatures - T)))]
+            rows.append((T, *jackknife(lambda b: single_histogram(T0, drop_block(E, b, blocks),
+                                                                  drop_block(M, b, blocks), T, N), blocks)))
+        return rows
+
+    log_Z = {}
+
+    def estimate(b, T):
+        energies = [drop_block(E, b, blocks) for (_, E, _) in data]
+        magnetizations = [drop_block(M, b, blocks) for (_, _, M) in data]
+        if b not in log_Z:
+            log_Z[b] = wham(betas, energies, log_Z=log_Z.get(None))
+        return wham_reweight(betas, energies, magnetizations, log_Z[b], T, N)
+
+    for T in targets:
+        rows.append((T, *jackknife(lambda b: estimate(b, T), blocks)))
+    return rows
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Single/multi-histogram reweighting of the *_series.bin sidecar")
+    parser.add_argument("series", help="Data*_series.bin written with series=1")
+    parser.add_argument("--tmin", type=float, required=True)
+    parser.add_argument("--tmax", type=float, required=True)
+    parser.add_argument("--dt", type=float, default=0.005)
+    parser.add_argument("--method", choices=["single", "wham"], default="wham")
+    parser.add_argument("--blocks", type=int, default=16, help="jackknife blocks of every series")
+    parser.add_argument("--window", type=float, default=None, help="use only the temperatures this close to the targets")
+    args = parser.parse_args()
+
+    steps = int(round((args.tmax - args.tmin) / args.dt))
+    targets = [args.tmin + i * args.dt for i in range(steps + 1)]
+    names = ["<|m|>", "<e>", "chi", "Cv", "U"]
+    print("T " + " ".join(f"{name} d{name}" for name in names))
+    for T, values, errors in reweight(args.series, targets, args.method, args.blocks, args.window):
+        print(f"{T:.4f} " + " ".join(f"{values[name]:.6g} {errors[name]:.2g}" for name in names))